@@ -0,0 +1,288 @@
+/* SDL-Man (Enemy AI)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sdlman.h"
+
+
+
+/* Local definitions. */
+#define SDLMAN_SCATTER_TIME 350 /* In loop cycles. */
+#define SDLMAN_CHASE_TIME 1000 /* In loop cycles. */
+#define SDLMAN_AMBUSH_DISTANCE 4 /* In tiles. */
+#define SDLMAN_SHY_DISTANCE 8 /* In tiles. */
+#define SDLMAN_AI_BUDGET 1000 /* In microseconds per loop cycle. */
+#define SDLMAN_AI_FLEE_UNITS 64 /* Tiles per slice between clock checks. */
+#define SDLMAN_AI_PATH_ROWS 4 /* Targets per slice between clock checks. */
+
+
+
+/* Personality by enemy texture index. */
+static const int sdlman_personality_table[SDLMAN_ENEMY_COUNT] = {
+	SDLMAN_PERSONALITY_CHASE,
+	SDLMAN_PERSONALITY_AMBUSH,
+	SDLMAN_PERSONALITY_PATROL,
+	SDLMAN_PERSONALITY_SHY,
+};
+
+/* Next corner to patrol, going clockwise. */
+static const int sdlman_patrol_table[4] = { 1, 3, 0, 2 };
+
+
+
+int sdlman_ai_init(sdlman_ai_t* ai, char* world, int enemy_speed)
+{
+	ai->paths = sdlman_path_table_create(world);
+	if (ai->paths == NULL) {
+		fprintf(stderr, "Error: Unable to allocate enemy path table.\n");
+		return -1;
+	}
+	ai->reserve.search =
+		(sdlman_reserve_search_t*)malloc(sizeof(sdlman_reserve_search_t));
+	if (ai->reserve.search == NULL) {
+		fprintf(stderr, "Error: Unable to allocate enemy path search.\n");
+		sdlman_path_table_destroy(ai->paths);
+		return -1;
+	}
+	sdlman_reserve_search_init(ai->reserve.search);
+	ai->shared_paths = 0;
+
+	sdlman_ai_reset(ai, enemy_speed);
+	return 0;
+}
+
+
+
+/* Start over on the same world, keeping the path table. */
+void sdlman_ai_reset(sdlman_ai_t* ai, int enemy_speed)
+{
+	int i;
+
+	/* Path rows and flee fields are computed as budget allows. */
+	sdlman_flee_field_init(&ai->flee[0]);
+	sdlman_flee_field_init(&ai->flee[1]);
+	ai->flee_front = 0;
+	ai->flee_cost_tile = -1;
+	ai->budget_us = SDLMAN_AI_BUDGET;
+	ai->budget_ticks = ai->budget_hits = 0;
+	sdlman_reserve_init(&ai->reserve, enemy_speed);
+	ai->tick = 0;
+
+	/* Start out by scattering to the corners. */
+	ai->scatter = 1;
+	ai->phase_time = SDLMAN_SCATTER_TIME;
+
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		ai->personality[i] = sdlman_personality_table[i];
+		ai->patrol_corner[i] = i % 4;
+	}
+}
+
+
+
+void sdlman_ai_free(sdlman_ai_t* ai)
+{
+	if (!ai->shared_paths) {
+		sdlman_path_table_destroy(ai->paths);
+		free(ai->reserve.search);
+	}
+	ai->paths = NULL;
+	ai->reserve.search = NULL;
+}
+
+
+
+/* Path table rows left to compute by this copy. */
+static int sdlman_ai_paths_pending(sdlman_ai_t* ai)
+{
+	return (!ai->shared_paths && ai->paths->rows < SDLMAN_WORLD_TILES);
+}
+
+
+
+/* Run pending path work until done or out of budget. Unfinished work is
+ * carried over, and the previous results are served meanwhile. */
+static void sdlman_ai_work(sdlman_ai_t* ai, char* world)
+{
+	Uint64 start;
+	sdlman_flee_field_t* back;
+
+	back = &ai->flee[!ai->flee_front];
+	if (back->stage == SDLMAN_FLEE_DONE && !sdlman_ai_paths_pending(ai))
+		return; /* Nothing pending. */
+
+	ai->budget_ticks++;
+	start = (ai->budget_us > 0) ? sdlman_timer_us() : 0;
+
+	while (1) {
+		if (back->stage != SDLMAN_FLEE_DONE) {
+			if (sdlman_flee_field_step(back, world, SDLMAN_AI_FLEE_UNITS))
+				ai->flee_front = !ai->flee_front;
+		}
+		else if (sdlman_path_table_step(ai->paths, world, SDLMAN_AI_PATH_ROWS)) {
+			return; /* All done. */
+		}
+
+		back = &ai->flee[!ai->flee_front];
+		if (back->stage == SDLMAN_FLEE_DONE && !sdlman_ai_paths_pending(ai))
+			return;
+
+		if (ai->budget_us > 0 &&
+			sdlman_timer_us() - start >= (Uint64)ai->budget_us) {
+			ai->budget_hits++;
+			return;
+		}
+	}
+}
+
+
+
+void sdlman_ai_update(sdlman_ai_t* ai, char* world,
+	sdlman_character_t* player, int boosted)
+{
+	int tile;
+	sdlman_flee_field_t* back;
+
+	ai->tick++;
+
+	if (boosted) {
+		/* Phase timers are paused while scared. Restart the flee field if the
+		 * player has moved on and no computation is already in progress. */
+		tile = sdlman_character_tile(player);
+		back = &ai->flee[!ai->flee_front];
+		if (ai->flee[ai->flee_front].player_tile != tile &&
+			back->stage == SDLMAN_FLEE_DONE)
+			sdlman_flee_field_begin(back, tile);
+	}
+	else {
+		ai->phase_time--;
+		if (ai->phase_time <= 0) {
+			ai->scatter = !ai->scatter;
+			if (ai->scatter)
+				ai->phase_time = SDLMAN_SCATTER_TIME;
+			else
+				ai->phase_time = SDLMAN_CHASE_TIME;
+		}
+	}
+
+	sdlman_ai_work(ai, world);
+}
+
+
+
+static int sdlman_ai_target(sdlman_ai_t* ai, char* world,
+	sdlman_character_t* player, int enemy_tile, int n)
+{
+	int i, tile, next, direction, home, player_tile;
+
+	home = ai->paths->corner[n % 4];
+	if (ai->scatter)
+		return home;
+
+	player_tile = sdlman_character_tile(player);
+
+	switch (ai->personality[n]) {
+	case SDLMAN_PERSONALITY_CHASE:
+		return player_tile;
+
+	case SDLMAN_PERSONALITY_AMBUSH:
+		if (player->moving_direction == SDLMAN_DIRECTION_NONE)
+			direction = player->looking_direction;
+		else
+			direction = player->moving_direction;
+		/* Walk ahead until the given distance or a wall. */
+		tile = player_tile;
+		for (i = 0; i < SDLMAN_AMBUSH_DISTANCE; i++) {
+			next = sdlman_tile_neighbour(tile, direction);
+			if (world[next] == SDLMAN_WORLD_WALL)
+				break;
+			tile = next;
+		}
+		return tile;
+
+	case SDLMAN_PERSONALITY_PATROL:
+		if (enemy_tile == ai->paths->corner[ai->patrol_corner[n]])
+			ai->patrol_corner[n] = sdlman_patrol_table[ai->patrol_corner[n]];
+		return ai->paths->corner[ai->patrol_corner[n]];
+
+	case SDLMAN_PERSONALITY_SHY:
+		if (sdlman_path_distance(ai->paths, enemy_tile, player_tile) >
+			SDLMAN_SHY_DISTANCE)
+			return player_tile;
+		return home;
+
+	default:
+		return player_tile;
+	}
+}
+
+
+
+/* Direction an enemy wants to go in, or none if it should keep going. Paths
+ * are planned around the ones other enemies have reserved, and the plain
+ * path data is used when there is no free path. */
+int sdlman_ai_direction(sdlman_ai_t* ai, char* world,
+	sdlman_character_t* player, sdlman_character_t* enemy, int n, int boosted)
+{
+	int i, tile, target, lowest, direction;
+	sdlman_flee_field_t* f;
+
+	tile = sdlman_character_tile(enemy);
+
+	if (boosted) {
+		f = &ai->flee[ai->flee_front];
+		if (f->player_tile == -1)
+			return SDLMAN_DIRECTION_NONE; /* Not computed yet. */
+		/* Shifted so the best place to flee to costs nothing, and kept until
+		 * the field is redone for another player tile. */
+		if (ai->flee_cost_tile != f->player_tile) {
+			lowest = 0;
+			for (i = 0; i < SDLMAN_WORLD_TILES; i++) {
+				if (f->distance[i] != -1 && f->value[i] < lowest)
+					lowest = f->value[i];
+			}
+			for (i = 0; i < SDLMAN_WORLD_TILES; i++) {
+				if (f->distance[i] == -1)
+					ai->flee_cost[i] = -1;
+				else
+					ai->flee_cost[i] = (short)(f->value[i] - lowest);
+			}
+			ai->flee_cost_tile = f->player_tile;
+		}
+		direction = sdlman_reserve_plan(&ai->reserve, world, n, tile, ai->tick,
+			ai->flee_cost, 0);
+		if (direction == SDLMAN_DIRECTION_NONE)
+			direction = sdlman_flee_field_direction(f, tile);
+		return direction;
+	}
+
+	target = sdlman_ai_target(ai, world, player, tile, n);
+	if (sdlman_path_distance(ai->paths, tile, target) <= 0)
+		return sdlman_path_direction(ai->paths, tile, target);
+
+	/* The row for the target holds the distance from every tile to it. */
+	direction = sdlman_reserve_plan(&ai->reserve, world, n, tile, ai->tick,
+		ai->paths->distance[target], 1);
+	if (direction == SDLMAN_DIRECTION_NONE)
+		direction = sdlman_path_direction(ai->paths, tile, target);
+	return direction;
+}
+
+
@@ -0,0 +1,420 @@
+/* SDL-Man (Bit-Parallel Flood Fill)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memset() and memcmp(). */
+#ifdef _MSC_VER
+#include <intrin.h> /* For bit scan. */
+#endif
+
+
+
+/* Local definitions. */
+#define SDLMAN_BITFILL_BENCH_RUNS 50
+#define SDLMAN_BITFILL_BENCH_LOOPS 10 /* Percent of walls knocked down. */
+
+
+
+static int sdlman_bitfill_lowest(Uint64 w)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long i;
+	_BitScanForward64(&i, w);
+	return (int)i;
+#elif defined(_MSC_VER)
+	unsigned long i;
+	if (_BitScanForward(&i, (unsigned long)w))
+		return (int)i;
+	_BitScanForward(&i, (unsigned long)(w >> 32));
+	return (int)i + 32;
+#elif defined(__GNUC__)
+	return __builtin_ctzll(w);
+#else
+	int i;
+	for (i = 0; (w & 1) == 0; i++)
+		w >>= 1;
+	return i;
+#endif
+}
+
+
+
+/* Bitmap of open tiles for world, NULL on failure. */
+sdlman_bitfill_t* sdlman_bitfill_create(char* world, int width, int height)
+{
+	int x, y, size, cells;
+	sdlman_bitfill_t* b;
+
+	b = (sdlman_bitfill_t*)calloc(1, sizeof(sdlman_bitfill_t));
+	if (b == NULL) {
+		fprintf(stderr, "Error: Unable to allocate flood fill.\n");
+		return NULL;
+	}
+
+	b->width = width;
+	b->height = height;
+	b->words = (width + 63) / 64;
+	b->stride = b->words + 2;
+	b->last_word = (width - 1) / 64;
+	b->last_bit = (width - 1) % 64;
+
+	size = b->stride * height;
+	cells = 2 * b->words * height; /* Row and word of each. */
+	b->open = (Uint64*)calloc(size, sizeof(Uint64));
+	b->visited = (Uint64*)calloc(size, sizeof(Uint64));
+	b->frontier = (Uint64*)calloc(size, sizeof(Uint64));
+	b->next = (Uint64*)calloc(size, sizeof(Uint64));
+	b->cells = (int*)malloc(sizeof(int) * cells);
+	b->next_cells = (int*)malloc(sizeof(int) * cells);
+	if (b->open == NULL || b->visited == NULL || b->frontier == NULL ||
+		b->next == NULL || b->cells == NULL || b->next_cells == NULL) {
+		fprintf(stderr, "Error: Unable to allocate flood fill.\n");
+		sdlman_bitfill_destroy(b);
+		return NULL;
+	}
+
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			if (world[(y * width) + x] != SDLMAN_WORLD_WALL)
+				b->open[(y * b->stride) + 1 + (x / 64)] |= (Uint64)1 << (x % 64);
+		}
+	}
+
+	return b;
+}
+
+
+
+void sdlman_bitfill_destroy(sdlman_bitfill_t* b)
+{
+	if (b == NULL)
+		return;
+
+	free(b->open);
+	free(b->visited);
+	free(b->frontier);
+	free(b->next);
+	free(b->cells);
+	free(b->next_cells);
+	free(b);
+}
+
+
+
+/* Or bits into word k of row y of the next frontier, and list the word
+ * if it was not already. */
+static void sdlman_bitfill_spread(sdlman_bitfill_t* b, int y, int k,
+	Uint64 bits, int* touched)
+{
+	Uint64* next;
+
+	next = b->next + (y * b->stride) + 1 + k;
+	if (*next == 0) {
+		b->next_cells[(*touched)++] = y;
+		b->next_cells[(*touched)++] = k;
+	}
+	*next |= bits;
+}
+
+
+
+/* Distance from the nearest of count tiles to every tile, -1 if not
+ * reachable. Returns number of tiles reached. */
+int sdlman_bitfill_distance(sdlman_bitfill_t* b, int* tiles, int count,
+	int* distance)
+{
+	int i, d, k, x, y, n, cells, touched, reached, first, band, start, rows;
+	int lead, trail;
+	Uint64 bit, up, cur, down, wrap, * f, * swap;
+
+	for (i = 0; i < b->width * b->height; i++)
+		distance[i] = -1;
+	memset(b->visited, 0, sizeof(Uint64) * b->stride * b->height);
+
+	/* Sources are the first frontier. The frontier is only non-zero in its
+	 * listed words, and the next frontier is all zero between layers. */
+	cells = reached = 0;
+	for (i = 0; i < count; i++) {
+		x = tiles[i] % b->width;
+		y = tiles[i] / b->width;
+		n = (y * b->stride) + 1 + (x / 64);
+		bit = (Uint64)1 << (x % 64);
+		if ((b->open[n] & bit) == 0 || (b->visited[n] & bit) != 0)
+			continue;
+		if (b->frontier[n] == 0) {
+			b->cells[cells++] = y;
+			b->cells[cells++] = x / 64;
+		}
+		b->visited[n] |= bit;
+		b->frontier[n] |= bit;
+		distance[tiles[i]] = 0;
+		reached++;
+	}
+
+	/* Worlds of one word per row, like the normal levels, are swept with
+	 * the rows above and below kept in registers. Only the band of rows
+	 * holding the frontier is swept, from the row before it to the row
+	 * after, and both wrap around like the world does. */
+	if (b->words == 1) {
+		wrap = (Uint64)1 << b->last_bit;
+		first = b->height;
+		x = -1;
+		for (i = 0; i < cells; i += 2) {
+			if (b->cells[i] < first)
+				first = b->cells[i];
+			if (b->cells[i] > x)
+				x = b->cells[i];
+		}
+		band = (x >= first) ? x - first + 1 : 0;
+		f = b->frontier + 1;
+		for (d = 1; band > 0; d++) {
+			if (band + 2 >= b->height) {
+				start = 0;
+				rows = b->height;
+			}
+			else {
+				start = (first == 0) ? b->height - 1 : first - 1;
+				rows = band + 2;
+			}
+			/* The old frontier is the next one after the swap, so it is
+			 * cleared as it is read. Its rows are all inside the sweep. */
+			y = start;
+			up = f[((y == 0) ? b->height - 1 : y - 1) * b->stride];
+			cur = f[y * b->stride];
+			cells = lead = trail = 0;
+			for (k = 0; k < rows; k++) {
+				x = (y == b->height - 1) ? 0 : y + 1;
+				down = f[x * b->stride];
+				f[x * b->stride] = 0;
+				n = (y * b->stride) + 1;
+				bit = (cur << 1) | (cur >> 1) | up | down;
+				if (cur & wrap)
+					bit |= 1;
+				if (cur & 1)
+					bit |= wrap;
+				bit &= b->open[n] & ~b->visited[n];
+				b->next[n] = bit;
+				up = cur;
+				cur = down;
+				if (bit != 0) {
+					if (cells == 0)
+						lead = k;
+					trail = k + 1;
+					b->visited[n] |= bit;
+					while (bit != 0) {
+						distance[(y * b->width) + sdlman_bitfill_lowest(bit)] = d;
+						bit &= bit - 1;
+						cells++;
+					}
+				}
+				y = x;
+			}
+			f[start * b->stride] = 0;
+			reached += cells;
+			first = start + lead;
+			if (first >= b->height)
+				first -= b->height;
+			band = trail - lead;
+			swap = b->frontier;
+			b->frontier = b->next;
+			b->next = swap;
+			f = b->frontier + 1;
+		}
+		return reached; /* The last layer swapped in was all zero. */
+	}
+
+	/* One layer at a time, only looking at words with a frontier. Each
+	 * spreads into its own row and the rows above and below, and only its
+	 * outermost bits carry into the words beside it. The next frontier is
+	 * then masked once per word it reached. Words are listed by row and
+	 * position, as dividing to get them back costs more than the rest. */
+	for (d = 1; cells > 0; d++) {
+		touched = 0;
+		for (i = 0; i < cells; i += 2) {
+			y = b->cells[i];
+			k = b->cells[i + 1];
+			n = (y * b->stride) + 1 + k;
+			cur = b->frontier[n];
+			b->frontier[n] = 0;
+
+			sdlman_bitfill_spread(b, y, k, (cur << 1) | (cur >> 1), &touched);
+			sdlman_bitfill_spread(b, (y == 0) ? b->height - 1 : y - 1, k, cur,
+				&touched);
+			sdlman_bitfill_spread(b, (y == b->height - 1) ? 0 : y + 1, k, cur,
+				&touched);
+			if (cur & 1) {
+				if (k == 0) /* Wrap around, like sdlman_world_collision. */
+					sdlman_bitfill_spread(b, y, b->last_word,
+						(Uint64)1 << b->last_bit, &touched);
+				else
+					sdlman_bitfill_spread(b, y, k - 1, (Uint64)1 << 63, &touched);
+			}
+			if (k == b->last_word) {
+				if ((cur >> b->last_bit) & 1)
+					sdlman_bitfill_spread(b, y, 0, 1, &touched);
+			}
+			else if (cur >> 63) {
+				sdlman_bitfill_spread(b, y, k + 1, 1, &touched);
+			}
+		}
+
+		cells = 0;
+		for (i = 0; i < touched; i += 2) {
+			y = b->next_cells[i];
+			k = b->next_cells[i + 1];
+			n = (y * b->stride) + 1 + k;
+			bit = b->next[n] & b->open[n] & ~b->visited[n];
+			b->next[n] = 0;
+			if (bit == 0)
+				continue;
+			b->visited[n] |= bit;
+			b->frontier[n] = bit;
+			b->cells[cells++] = y;
+			b->cells[cells++] = k;
+			while (bit != 0) {
+				distance[(y * b->width) + (k * 64) + sdlman_bitfill_lowest(bit)] = d;
+				bit &= bit - 1;
+				reached++;
+			}
+		}
+	}
+
+	return reached;
+}
+
+
+
+/* Plain queue breadth first search on a wrapping world, for comparison. */
+static void sdlman_bitfill_queue_distance(char* world, int width, int height,
+	int tile, int* distance, int* queue)
+{
+	int i, x, y, n, head, tail;
+
+	for (i = 0; i < width * height; i++)
+		distance[i] = -1;
+
+	head = tail = 0;
+	distance[tile] = 0;
+	queue[tail++] = tile;
+	while (head < tail) {
+		tile = queue[head++];
+		x = tile % width;
+		y = tile / width;
+		for (i = 0; i < 4; i++) {
+			switch (i) {
+			case 0:
+				n = (((y + height - 1) % height) * width) + x;
+				break;
+			case 1:
+				n = (((y + 1) % height) * width) + x;
+				break;
+			case 2:
+				n = (y * width) + ((x + width - 1) % width);
+				break;
+			default:
+				n = (y * width) + ((x + 1) % width);
+				break;
+			}
+			if (world[n] == SDLMAN_WORLD_WALL || distance[n] != -1)
+				continue;
+			distance[n] = distance[tile] + 1;
+			queue[tail++] = n;
+		}
+	}
+}
+
+
+
+/* Time distance maps from random tiles of a generated size by size maze,
+ * against a queue search, and check that they agree. */
+int sdlman_bitfill_bench(int size)
+{
+	int i, tile, mismatches;
+	int *distance, *expected, *queue;
+	char* world;
+	Uint64 start, bit_total, queue_total;
+	sdlman_bitfill_t* b;
+
+	if (size < 3) {
+		fprintf(stderr, "Error: Maze size must be at least 3.\n");
+		return -1;
+	}
+
+	world = (char*)malloc(size * size);
+	distance = (int*)malloc(sizeof(int) * size * size);
+	expected = (int*)malloc(sizeof(int) * size * size);
+	queue = (int*)malloc(sizeof(int) * size * size);
+	if (world == NULL || distance == NULL || expected == NULL || queue == NULL) {
+		fprintf(stderr, "Error: Unable to allocate %dx%d maze.\n", size, size);
+		free(world);
+		free(distance);
+		free(expected);
+		free(queue);
+		return -1;
+	}
+
+	b = NULL;
+	if (sdlman_maze_generate(world, size, size, (unsigned int)size,
+		SDLMAN_BITFILL_BENCH_LOOPS) == 0)
+		b = sdlman_bitfill_create(world, size, size);
+	if (b == NULL) {
+		free(world);
+		free(distance);
+		free(expected);
+		free(queue);
+		return -1;
+	}
+
+	mismatches = 0;
+	bit_total = queue_total = 0;
+	for (i = 0; i < SDLMAN_BITFILL_BENCH_RUNS; i++) {
+		do {
+			tile = rand() % (size * size);
+		} while (world[tile] == SDLMAN_WORLD_WALL);
+
+		start = sdlman_timer_us();
+		sdlman_bitfill_distance(b, &tile, 1, distance);
+		bit_total += sdlman_timer_us() - start;
+
+		start = sdlman_timer_us();
+		sdlman_bitfill_queue_distance(world, size, size, tile, expected, queue);
+		queue_total += sdlman_timer_us() - start;
+
+		if (memcmp(distance, expected, sizeof(int) * size * size) != 0)
+			mismatches++;
+	}
+
+	printf("Maze %dx%d, %d words per row.\n", size, size, b->words);
+	printf("Bit-parallel: %.1f us, queue: %.1f us average per distance map.\n",
+		(double)bit_total / SDLMAN_BITFILL_BENCH_RUNS,
+		(double)queue_total / SDLMAN_BITFILL_BENCH_RUNS);
+	if (mismatches > 0)
+		printf("%d of %d distance maps did not match.\n",
+			mismatches, SDLMAN_BITFILL_BENCH_RUNS);
+
+	sdlman_bitfill_destroy(b);
+	free(world);
+	free(distance);
+	free(expected);
+	free(queue);
+	return (mismatches == 0) ? 0 : -1;
+}
@@ -0,0 +1,219 @@
+/* SDL-Man (Autopilot)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memcmp() and memcpy(). */
+
+
+
+/* Local definitions. */
+#define SDLMAN_BOT_DANGER 5 /* In tiles from the nearest enemy. */
+#define SDLMAN_BOT_DANGER_COST 20 /* Per tile closer than the danger radius. */
+
+
+
+/* With paths, the complete path table of the world, distances are looked up
+ * in it. Otherwise the bot keeps distance maps of its own. */
+int sdlman_bot_init(sdlman_bot_t* bot, char* world, sdlman_path_table_t* paths)
+{
+	bot->paths = paths;
+	bot->fill = NULL;
+	if (paths == NULL) {
+		bot->fill = sdlman_bitfill_create(world, SDLMAN_WORLD_X_SIZE,
+			SDLMAN_WORLD_Y_SIZE);
+		if (bot->fill == NULL) {
+			fprintf(stderr, "Error: Unable to allocate autopilot.\n");
+			return -1;
+		}
+	}
+	bot->pellets_left = -1;
+	bot->enemies = -1;
+
+	return 0;
+}
+
+
+
+void sdlman_bot_free(sdlman_bot_t* bot)
+{
+	sdlman_bitfill_destroy(bot->fill);
+	bot->fill = NULL;
+}
+
+
+
+/* Distance from tile to the nearest of the sources in the path table, -1
+ * if none can be reached. */
+static int sdlman_bot_nearest(sdlman_path_table_t* paths, int* source,
+	int sources, int tile)
+{
+	int i, distance, nearest;
+
+	nearest = -1;
+	for (i = 0; i < sources; i++) {
+		distance = paths->distance[source[i]][tile];
+		if (distance != -1 && (nearest == -1 || distance < nearest))
+			nearest = distance;
+	}
+
+	return nearest;
+}
+
+
+
+/* Lower is better. Tiles close to an enemy cost more the closer they are. */
+static int sdlman_bot_value(sdlman_bot_t* bot, int tile)
+{
+	int value, pellet, enemy;
+
+	if (bot->paths != NULL) {
+		pellet = sdlman_bot_nearest(bot->paths, bot->sources, bot->pellets_left,
+			tile);
+		enemy = sdlman_bot_nearest(bot->paths, bot->enemy_tile, bot->enemies,
+			tile);
+	}
+	else {
+		pellet = bot->pellet_distance[tile];
+		enemy = bot->enemy_distance[tile];
+	}
+
+	if (pellet == -1)
+		value = SDLMAN_WORLD_TILES;
+	else
+		value = pellet;
+
+	if (enemy != -1 && enemy < SDLMAN_BOT_DANGER)
+		value += (SDLMAN_BOT_DANGER - enemy) * SDLMAN_BOT_DANGER_COST;
+
+	return value;
+}
+
+
+
+/* Block the player gets to next going in direction. Between blocks that
+ * is the one its front edge is in, not a neighbour of its middle. */
+static int sdlman_bot_ahead(sdlman_character_t* player, int direction)
+{
+	int x, y;
+
+	if (sdlman_character_aligned(player))
+		return sdlman_tile_neighbour(sdlman_character_tile(player), direction);
+
+	x = player->x + (SDLMAN_CHARACTER_SIZE / 2);
+	y = player->y + (SDLMAN_CHARACTER_SIZE / 2);
+	switch (direction) {
+	case SDLMAN_DIRECTION_UP:
+		y = player->y;
+		break;
+	case SDLMAN_DIRECTION_DOWN:
+		y = player->y + SDLMAN_CHARACTER_SIZE - 1;
+		break;
+	case SDLMAN_DIRECTION_LEFT:
+		x = player->x;
+		break;
+	case SDLMAN_DIRECTION_RIGHT:
+		x = player->x + SDLMAN_CHARACTER_SIZE - 1;
+		break;
+	default:
+		break;
+	}
+
+	/* Offset by a whole world, for wrapping around the edges. */
+	x = ((x + (SDLMAN_WORLD_X_SIZE * SDLMAN_BLOCK_SIZE)) / SDLMAN_BLOCK_SIZE) %
+		SDLMAN_WORLD_X_SIZE;
+	y = ((y + (SDLMAN_WORLD_Y_SIZE * SDLMAN_BLOCK_SIZE)) / SDLMAN_BLOCK_SIZE) %
+		SDLMAN_WORLD_Y_SIZE;
+
+	return (y * SDLMAN_WORLD_X_SIZE) + x;
+}
+
+
+
+/* Direction for the player, heading for the nearest pellet left while
+ * keeping away from enemies. Turns are only made inside a block, where the
+ * player can take them, but it may turn back at any time. */
+int sdlman_bot_direction(sdlman_bot_t* bot, char* world,
+	sdlman_character_t* player, sdlman_character_t* enemy,
+	sdlman_pellet_t* pellet, int total)
+{
+	int i, n, d, next, value, best, best_direction;
+	int tile[SDLMAN_ENEMY_COUNT];
+
+	/* Tiles of every pellet left and every enemy. Without a path table,
+	 * distance maps from them all at once are redone only when a pellet is
+	 * eaten or an enemy has moved on to another tile. */
+	n = 0;
+	for (i = 0; i < total; i++) {
+		if (pellet[i].consumed)
+			continue;
+		bot->sources[n++] = ((pellet[i].y / SDLMAN_BLOCK_SIZE) *
+			SDLMAN_WORLD_X_SIZE) + (pellet[i].x / SDLMAN_BLOCK_SIZE);
+	}
+	if (bot->paths == NULL && n != bot->pellets_left)
+		sdlman_bitfill_distance(bot->fill, bot->sources, n,
+			bot->pellet_distance);
+	bot->pellets_left = n;
+
+	n = 0;
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		if (enemy[i].killed)
+			continue;
+		tile[n++] = sdlman_character_tile(&enemy[i]);
+	}
+	if (n != bot->enemies ||
+		memcmp(tile, bot->enemy_tile, n * sizeof(int)) != 0) {
+		if (bot->paths == NULL)
+			sdlman_bitfill_distance(bot->fill, tile, n, bot->enemy_distance);
+		memcpy(bot->enemy_tile, tile, n * sizeof(int));
+		bot->enemies = n;
+	}
+
+	/* Keep going unless something else is strictly better. */
+	best = -1;
+	best_direction = player->moving_direction;
+	if (best_direction != SDLMAN_DIRECTION_NONE) {
+		next = sdlman_bot_ahead(player, best_direction);
+		if (world[next] != SDLMAN_WORLD_WALL)
+			best = sdlman_bot_value(bot, next);
+	}
+
+	for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+		if (d == player->moving_direction)
+			continue;
+		if (!sdlman_character_aligned(player) &&
+			player->moving_direction != SDLMAN_DIRECTION_NONE &&
+			d != sdlman_direction_opposite[player->moving_direction])
+			continue; /* Can not turn between blocks. */
+		next = sdlman_bot_ahead(player, d);
+		if (world[next] == SDLMAN_WORLD_WALL)
+			continue;
+		value = sdlman_bot_value(bot, next);
+		if (best == -1 || value < best) {
+			best = value;
+			best_direction = d;
+		}
+	}
+
+	if (best == -1)
+		return SDLMAN_DIRECTION_NONE;
+	return best_direction;
+}
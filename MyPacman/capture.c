@@ -0,0 +1,345 @@
+/* SDL-Man (Capture)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memcpy(). */
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define SDLMAN_PIPE_MODE "wb"
+#else
+#define SDLMAN_PIPE_MODE "w"
+#endif
+
+
+
+/* Local definitions. */
+#define SDLMAN_CAPTURE_MAX_REPEAT 250 /* In frames, to fill a gap with. */
+
+
+
+static void sdlman_capture_free(sdlman_capture_t* c)
+{
+	int i;
+
+	if (c->wake != NULL)
+		SDL_DestroyCond(c->wake);
+	if (c->lock != NULL)
+		SDL_DestroyMutex(c->lock);
+	for (i = 0; i < SDLMAN_CAPTURE_FRAMES; i++)
+		free(c->frame[i]);
+	free(c->rgb);
+	free(c->yuv);
+	if (c->fh != NULL) {
+		if (c->pipe)
+			pclose(c->fh);
+		else
+			fclose(c->fh);
+	}
+	free(c);
+}
+
+
+
+/* Frame from the ring to packed 8-bit RGB, in the screen's pixel format. */
+static void sdlman_capture_rgb(sdlman_capture_t* c, Uint8* src)
+{
+	int x, y;
+	Uint32 p;
+	Uint8* dst;
+	SDL_PixelFormat* f;
+
+	f = &c->format;
+	dst = c->rgb;
+	for (y = 0; y < c->height; y++) {
+		for (x = 0; x < c->width; x++) {
+			if (c->bytes_per_pixel == 4)
+				p = ((Uint32*)src)[x];
+			else
+				p = ((Uint16*)src)[x];
+			*dst++ = (Uint8)(((p & f->Rmask) >> f->Rshift) << f->Rloss);
+			*dst++ = (Uint8)(((p & f->Gmask) >> f->Gshift) << f->Gloss);
+			*dst++ = (Uint8)(((p & f->Bmask) >> f->Bshift) << f->Bloss);
+		}
+		src += c->width * c->bytes_per_pixel;
+	}
+}
+
+
+
+/* Packed RGB to planar 4:2:0 with BT.601 studio range, colour taken from
+ * the mean of each 2 x 2 block. */
+static void sdlman_capture_yuv(sdlman_capture_t* c)
+{
+	int x, y, r, g, b, stride;
+	Uint8* s, * py, * pu, * pv;
+
+	stride = c->width * 3;
+	py = c->yuv;
+	pu = py + (c->width * c->height);
+	pv = pu + ((c->width / 2) * (c->height / 2));
+
+	s = c->rgb;
+	for (y = 0; y < c->width * c->height; y++) {
+		*py++ = (Uint8)((((66 * s[0]) + (129 * s[1]) + (25 * s[2]) + 128) >> 8) +
+			16);
+		s += 3;
+	}
+
+	for (y = 0; y < c->height; y += 2) {
+		for (x = 0; x < c->width; x += 2) {
+			s = c->rgb + (y * stride) + (x * 3);
+			r = (s[0] + s[3] + s[stride] + s[stride + 3] + 2) >> 2;
+			g = (s[1] + s[4] + s[stride + 1] + s[stride + 4] + 2) >> 2;
+			b = (s[2] + s[5] + s[stride + 2] + s[stride + 5] + 2) >> 2;
+			*pu++ = (Uint8)((((-38 * r) - (74 * g) + (112 * b) + 128) >> 8) + 128);
+			*pv++ = (Uint8)((((112 * r) - (94 * g) - (18 * b) + 128) >> 8) + 128);
+		}
+	}
+}
+
+
+
+/* Write the last converted frame once more, or the first time. */
+static void sdlman_capture_write(sdlman_capture_t* c)
+{
+	int ok;
+
+	if (c->failed)
+		return;
+
+	if (c->y4m)
+		ok = (fwrite("FRAME\n", 1, 6, c->fh) == 6 &&
+			fwrite(c->yuv, 1, c->frame_size, c->fh) == (size_t)c->frame_size);
+	else
+		ok = (fwrite(c->rgb, 1, c->frame_size, c->fh) == (size_t)c->frame_size);
+
+	if (!ok) {
+		fprintf(stderr, "Error: Unable to write captured frame.\n");
+		c->failed = 1; /* Frames are still taken out of the ring. */
+		return;
+	}
+	c->written++;
+}
+
+
+
+/* Take frames out of the ring in order and write them. Gaps in time, from
+ * frames drawn late or dropped, are filled by repeating the frame before,
+ * so the stream plays back at the speed it was shown. */
+static int sdlman_capture_thread(void* data)
+{
+	int slot;
+	Uint32 tick, repeat;
+	sdlman_capture_t* c;
+
+	c = (sdlman_capture_t*)data;
+
+	SDL_mutexP(c->lock);
+	while (1) {
+		while (c->head == c->tail && !c->quit)
+			SDL_CondWait(c->wake, c->lock);
+		if (c->head == c->tail)
+			break; /* Quit, with the ring empty. */
+		slot = c->tail % SDLMAN_CAPTURE_FRAMES;
+		tick = c->frame_tick[slot];
+		SDL_mutexV(c->lock);
+
+		if (c->written > 0) {
+			repeat = tick - c->write_tick - 1;
+			if (repeat > SDLMAN_CAPTURE_MAX_REPEAT)
+				repeat = SDLMAN_CAPTURE_MAX_REPEAT;
+			while (repeat-- > 0) {
+				sdlman_capture_write(c);
+				c->repeated++;
+			}
+		}
+		sdlman_capture_rgb(c, c->frame[slot]);
+		if (c->y4m)
+			sdlman_capture_yuv(c);
+		sdlman_capture_write(c);
+		c->write_tick = tick;
+
+		SDL_mutexP(c->lock);
+		c->tail++;
+	}
+	SDL_mutexV(c->lock);
+
+	return 0;
+}
+
+
+
+/* Record frames shown on a screen to a file, or to the standard input of a
+ * command if the name starts with '|'. Commands and names ending in ".y4m"
+ * get a YUV4MPEG2 stream, other files raw 24-bit RGB, at one frame per
+ * loop cycle. All buffers are allocated here. */
+sdlman_capture_t* sdlman_capture_open(char* filename, SDL_Surface* screen)
+{
+	int i, length;
+	sdlman_capture_t* c;
+
+	if (screen->format->BytesPerPixel != 2 &&
+		screen->format->BytesPerPixel != 4) {
+		fprintf(stderr, "Error: Capture needs 16 or 32 bits per pixel.\n");
+		return NULL;
+	}
+
+	c = (sdlman_capture_t*)malloc(sizeof(sdlman_capture_t));
+	if (c == NULL) {
+		fprintf(stderr, "Error: Unable to allocate capture.\n");
+		return NULL;
+	}
+	memset(c, 0, sizeof(sdlman_capture_t));
+	c->width = screen->w;
+	c->height = screen->h;
+	c->bytes_per_pixel = screen->format->BytesPerPixel;
+	c->format = *screen->format;
+	c->format.palette = NULL;
+
+	length = strlen(filename);
+	c->y4m = (filename[0] == '|' ||
+		(length > 4 && strcmp(filename + length - 4, ".y4m") == 0));
+	if (c->y4m)
+		c->frame_size = (c->width * c->height) + (2 * (c->width / 2) *
+			(c->height / 2));
+	else
+		c->frame_size = c->width * c->height * 3;
+
+	for (i = 0; i < SDLMAN_CAPTURE_FRAMES; i++) {
+		c->frame[i] = (Uint8*)malloc(c->width * c->height * c->bytes_per_pixel);
+		if (c->frame[i] == NULL)
+			break;
+	}
+	c->rgb = (Uint8*)malloc(c->width * c->height * 3);
+	if (c->y4m)
+		c->yuv = (Uint8*)malloc(c->frame_size);
+	if (i < SDLMAN_CAPTURE_FRAMES || c->rgb == NULL ||
+		(c->y4m && c->yuv == NULL)) {
+		fprintf(stderr, "Error: Unable to allocate capture frames.\n");
+		sdlman_capture_free(c);
+		return NULL;
+	}
+
+	if (filename[0] == '|') {
+		c->pipe = 1;
+		c->fh = popen(filename + 1, SDLMAN_PIPE_MODE);
+	}
+	else {
+		c->fh = fopen(filename, "wb");
+	}
+	if (c->fh == NULL) {
+		fprintf(stderr, "Error: Unable to open capture file: %s\n", filename);
+		sdlman_capture_free(c);
+		return NULL;
+	}
+	if (c->y4m)
+		fprintf(c->fh, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+			c->width, c->height, 1000 / SDLMAN_GAME_SPEED);
+
+	c->lock = SDL_CreateMutex();
+	c->wake = SDL_CreateCond();
+	if (c->lock == NULL || c->wake == NULL) {
+		fprintf(stderr, "Error: Unable to create capture lock: %s\n",
+			SDL_GetError());
+		sdlman_capture_free(c);
+		return NULL;
+	}
+
+	c->thread = SDL_CreateThread(sdlman_capture_thread, c);
+	if (c->thread == NULL) {
+		fprintf(stderr, "Error: Unable to start capture thread: %s\n",
+			SDL_GetError());
+		sdlman_capture_free(c);
+		return NULL;
+	}
+
+	fprintf(stderr, "Info: Capturing %dx%d %s to %s.\n", c->width, c->height,
+		c->y4m ? "YUV4MPEG2" : "raw RGB", filename);
+	return c;
+}
+
+
+
+/* Copy the screen into the ring, to be written later. Never waits for the
+ * writer: the frame is dropped if the ring is full. Frames are numbered by
+ * the clock, and only one is kept for each loop cycle. */
+void sdlman_capture_frame(sdlman_capture_t* c, SDL_Surface* screen)
+{
+	int i, full, row_bytes;
+	Uint32 tick;
+	Uint8* src, * dst;
+
+	tick = SDL_GetTicks() / SDLMAN_GAME_SPEED;
+	if (c->captured > 0 && tick == c->capture_tick)
+		return;
+
+	SDL_mutexP(c->lock);
+	full = (c->head - c->tail >= SDLMAN_CAPTURE_FRAMES);
+	SDL_mutexV(c->lock);
+	if (full) {
+		c->dropped++;
+		return;
+	}
+
+	/* The slot at the head is not read by the writer until handed over. */
+	if (SDL_MUSTLOCK(screen) && SDL_LockSurface(screen) != 0)
+		return;
+	src = (Uint8*)screen->pixels;
+	dst = c->frame[c->head % SDLMAN_CAPTURE_FRAMES];
+	row_bytes = c->width * c->bytes_per_pixel;
+	for (i = 0; i < c->height; i++) {
+		memcpy(dst, src, row_bytes);
+		src += screen->pitch;
+		dst += row_bytes;
+	}
+	if (SDL_MUSTLOCK(screen))
+		SDL_UnlockSurface(screen);
+
+	c->frame_tick[c->head % SDLMAN_CAPTURE_FRAMES] = tick;
+	c->capture_tick = tick;
+	c->captured++;
+
+	SDL_mutexP(c->lock);
+	c->head++;
+	SDL_CondSignal(c->wake);
+	SDL_mutexV(c->lock);
+}
+
+
+
+/* Write what is left in the ring and close the file. */
+void sdlman_capture_close(sdlman_capture_t* c)
+{
+	SDL_mutexP(c->lock);
+	c->quit = 1;
+	SDL_CondSignal(c->wake);
+	SDL_mutexV(c->lock);
+	SDL_WaitThread(c->thread, NULL);
+
+	fprintf(stderr, "Info: Captured %lu frames and dropped %lu.\n",
+		c->captured, c->dropped);
+	fprintf(stderr, "Info: Wrote %lu frames, %lu of them repeats.\n",
+		c->written, c->repeated);
+
+	sdlman_capture_free(c);
+}
@@ -0,0 +1,250 @@
+/* SDL-Man (Difficulty Estimate)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+/* Local definitions. */
+#define SDLMAN_DIFFICULTY_PAIRS (SDLMAN_MAX_WORLD * SDLMAN_MAX_ENEMY_SPEED)
+#define SDLMAN_DIFFICULTY_PATH_LENGTH 256
+
+
+
+/* Outcome of one game. */
+typedef struct sdlman_difficulty_game_s {
+	int status;
+	int ticks;
+	int score;
+} sdlman_difficulty_game_t;
+
+typedef struct sdlman_difficulty_s {
+	int games; /* Per world and enemy speed. */
+	sdlman_policy_t policy;
+	sdlman_level_t level[SDLMAN_MAX_WORLD];
+	sdlman_player_t* player[SDLMAN_PARALLEL_MAX_WORKERS];
+	sdlman_difficulty_game_t* result; /* By world, enemy speed and game. */
+	int* score; /* Sorted scores of one pair, for the report. */
+	sdlman_heatmap_t* heatmap[SDLMAN_PARALLEL_MAX_WORKERS][SDLMAN_MAX_WORLD];
+} sdlman_difficulty_t;
+
+
+
+static void sdlman_difficulty_game(void* data, int n, int worker)
+{
+	int world, enemy_speed, status;
+	sdlman_difficulty_t* d;
+	sdlman_player_t* pl;
+
+	d = (sdlman_difficulty_t*)data;
+	world = n / (d->games * SDLMAN_MAX_ENEMY_SPEED);
+	enemy_speed = (n / d->games) % SDLMAN_MAX_ENEMY_SPEED;
+
+	d->result[n].status = -1;
+	if (d->level[world].paths == NULL)
+		return; /* World not loaded. */
+
+	pl = d->player[worker];
+	pl->heatmap = d->heatmap[worker][world];
+	status = sdlman_player_play(pl, &d->policy, &d->level[world],
+		enemy_speed + 1, (unsigned int)n + 1, SDLMAN_AUTOPILOT_TIME);
+	d->result[n].status = status;
+	d->result[n].ticks = (int)pl->env->game.ai.tick;
+	d->result[n].score = sdlman_game_score(&pl->env->game);
+}
+
+
+
+static int sdlman_difficulty_compare(const void* a, const void* b)
+{
+	return *(const int*)a - *(const int*)b;
+}
+
+
+
+static void sdlman_difficulty_report(sdlman_difficulty_t* d, int workers,
+	Uint64 elapsed)
+{
+	int i, n, pair, cleared, played;
+	double ticks, score;
+	sdlman_difficulty_game_t* r;
+
+	printf("%d games of %s for each world and enemy speed, %d workers, "
+		"%.1f s.\n", d->games, d->policy.name, workers,
+		(double)elapsed / 1000000.0);
+	printf("World Speed Cleared   Ticks    Mean   10%%   50%%   90%%\n");
+
+	for (pair = 0; pair < SDLMAN_DIFFICULTY_PAIRS; pair++) {
+		r = d->result + (pair * d->games);
+		cleared = played = 0;
+		ticks = score = 0.0;
+		for (i = 0; i < d->games; i++) {
+			if (r[i].status < 0)
+				continue;
+			if (r[i].status == SDLMAN_GAME_CLEARED)
+				cleared++;
+			ticks += r[i].ticks;
+			score += r[i].score;
+			d->score[played++] = r[i].score;
+		}
+		if (played == 0)
+			continue;
+
+		qsort(d->score, played, sizeof(int), sdlman_difficulty_compare);
+		n = played - 1;
+		printf("%5d %5d %6.1f%% %7.0f %7.0f %5d %5d %5d\n",
+			(pair / SDLMAN_MAX_ENEMY_SPEED) + 1,
+			(pair % SDLMAN_MAX_ENEMY_SPEED) + 1,
+			(100.0 * cleared) / played, ticks / played, score / played,
+			d->score[n / 10], d->score[n / 2], d->score[(n * 9) / 10]);
+	}
+}
+
+
+
+/* Sum the heatmaps of all workers and write them out per world, as a
+ * binary grid and an image. */
+static int sdlman_difficulty_heatmaps(sdlman_difficulty_t* d, int workers,
+	char* prefix)
+{
+	int i, j;
+	char filename[SDLMAN_DIFFICULTY_PATH_LENGTH];
+
+	for (j = 0; j < SDLMAN_MAX_WORLD; j++) {
+		if (d->level[j].paths == NULL)
+			continue;
+		for (i = 1; i < workers; i++)
+			sdlman_heatmap_merge(d->heatmap[0][j], d->heatmap[i][j]);
+
+		snprintf(filename, SDLMAN_DIFFICULTY_PATH_LENGTH, "%s%d.heat", prefix,
+			j + 1);
+		if (sdlman_heatmap_write(d->heatmap[0][j], filename) != 0)
+			return -1;
+		snprintf(filename, SDLMAN_DIFFICULTY_PATH_LENGTH, "%s%d.pgm", prefix,
+			j + 1);
+		if (sdlman_heatmap_write_pgm(d->heatmap[0][j], d->level[j].world,
+			filename) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+
+static void sdlman_difficulty_free(sdlman_difficulty_t* d)
+{
+	int i, j;
+
+	for (i = 0; i < SDLMAN_PARALLEL_MAX_WORKERS; i++) {
+		sdlman_player_destroy(d->player[i]);
+		for (j = 0; j < SDLMAN_MAX_WORLD; j++)
+			sdlman_heatmap_destroy(d->heatmap[i][j]);
+	}
+	for (i = 0; i < SDLMAN_MAX_WORLD; i++)
+		sdlman_level_free(&d->level[i]);
+	sdlman_policy_unload(&d->policy);
+	free(d->result);
+	free(d->score);
+	free(d);
+}
+
+
+
+/* Play games games with the autopilot bot on every world and enemy speed,
+ * on all processors, and print how often it clears them, how long it
+ * lasts and how its scores spread. With a heatmap prefix, where everyone
+ * went and died is also written per world. */
+int sdlman_difficulty(int games, char* heatmap_prefix)
+{
+	int i, j, workers, loaded;
+	Uint64 start;
+	sdlman_difficulty_t* d;
+
+	if (games < 1) {
+		fprintf(stderr, "Error: Need at least one game.\n");
+		return -1;
+	}
+
+	d = (sdlman_difficulty_t*)calloc(1, sizeof(sdlman_difficulty_t));
+	if (d == NULL) {
+		fprintf(stderr, "Error: Unable to allocate difficulty estimate.\n");
+		return -1;
+	}
+	d->games = games;
+	sdlman_policy_load(&d->policy, "greedy");
+
+	d->result = (sdlman_difficulty_game_t*)malloc(
+		sizeof(sdlman_difficulty_game_t) * SDLMAN_DIFFICULTY_PAIRS * games);
+	d->score = (int*)malloc(sizeof(int) * games);
+	if (d->result == NULL || d->score == NULL) {
+		fprintf(stderr, "Error: Unable to allocate difficulty results.\n");
+		sdlman_difficulty_free(d);
+		return -1;
+	}
+
+	loaded = 0;
+	for (i = 0; i < SDLMAN_MAX_WORLD; i++) {
+		if (sdlman_level_load(&d->level[i], i + 1) != 0) {
+			fprintf(stderr, "Warning: Skipping world %d.\n", i + 1);
+			continue;
+		}
+		loaded++;
+	}
+	if (loaded == 0) {
+		fprintf(stderr, "Error: No world could be loaded.\n");
+		sdlman_difficulty_free(d);
+		return -1;
+	}
+
+	workers = sdlman_cpu_count();
+	if (workers > SDLMAN_PARALLEL_MAX_WORKERS)
+		workers = SDLMAN_PARALLEL_MAX_WORKERS;
+	for (i = 0; i < workers; i++) {
+		d->player[i] = sdlman_player_create();
+		if (d->player[i] == NULL) {
+			sdlman_difficulty_free(d);
+			return -1;
+		}
+		if (heatmap_prefix == NULL)
+			continue;
+		for (j = 0; j < SDLMAN_MAX_WORLD; j++) {
+			d->heatmap[i][j] = sdlman_heatmap_create();
+			if (d->heatmap[i][j] == NULL) {
+				sdlman_difficulty_free(d);
+				return -1;
+			}
+		}
+	}
+
+	start = sdlman_timer_us();
+	workers = sdlman_parallel_run(workers, SDLMAN_DIFFICULTY_PAIRS * games,
+		sdlman_difficulty_game, d);
+	if (workers > 0)
+		sdlman_difficulty_report(d, workers, sdlman_timer_us() - start);
+	if (workers > 0 && heatmap_prefix != NULL &&
+		sdlman_difficulty_heatmaps(d, workers, heatmap_prefix) != 0)
+		workers = -1;
+
+	sdlman_difficulty_free(d);
+	return (workers > 0) ? 0 : -1;
+}
@@ -0,0 +1,383 @@
+/* SDL-Man (Display)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memcpy(). */
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SDLMAN_DISPLAY_SSE2
+#include <emmintrin.h> /* For 128-bit pixel shuffles. */
+#endif
+
+
+
+/* Local definitions. */
+#define SDLMAN_DISPLAY_WIDTH (SDLMAN_WORLD_X_SIZE * SDLMAN_BLOCK_SIZE)
+#define SDLMAN_DISPLAY_HEIGHT (SDLMAN_WORLD_Y_SIZE * SDLMAN_BLOCK_SIZE)
+#define SDLMAN_SCALE_BENCH_RUNS 100
+
+
+
+/* Repeat each of n 32-bit pixels scale times. Four pixels are read at once,
+ * and spread over two, three or four writes. */
+static void sdlman_scale_row32(const Uint32* src, Uint32* dst, int n,
+	int scale)
+{
+	int i, k;
+#ifdef SDLMAN_DISPLAY_SSE2
+	__m128i v;
+#endif
+
+	i = 0;
+#ifdef SDLMAN_DISPLAY_SSE2
+	if (scale == 2) {
+		for (; i + 4 <= n; i += 4) {
+			v = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(v, v));
+			_mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(v, v));
+			dst += 8;
+		}
+	}
+	else if (scale == 3) {
+		for (; i + 4 <= n; i += 4) {
+			v = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi32(v, 0x40));
+			_mm_storeu_si128((__m128i*)(dst + 4), _mm_shuffle_epi32(v, 0xa5));
+			_mm_storeu_si128((__m128i*)(dst + 8), _mm_shuffle_epi32(v, 0xfe));
+			dst += 12;
+		}
+	}
+	else if (scale == 4) {
+		for (; i + 4 <= n; i += 4) {
+			v = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi32(v, 0x00));
+			_mm_storeu_si128((__m128i*)(dst + 4), _mm_shuffle_epi32(v, 0x55));
+			_mm_storeu_si128((__m128i*)(dst + 8), _mm_shuffle_epi32(v, 0xaa));
+			_mm_storeu_si128((__m128i*)(dst + 12), _mm_shuffle_epi32(v, 0xff));
+			dst += 16;
+		}
+	}
+#endif
+
+	for (; i < n; i++)
+		for (k = 0; k < scale; k++)
+			*dst++ = src[i];
+}
+
+
+
+/* Same for 16-bit pixels, eight at a time. Three times is left to the
+ * plain loop, since it does not fall on 16 byte boundaries. */
+static void sdlman_scale_row16(const Uint16* src, Uint16* dst, int n,
+	int scale)
+{
+	int i, k;
+#ifdef SDLMAN_DISPLAY_SSE2
+	__m128i v, lo, hi;
+#endif
+
+	i = 0;
+#ifdef SDLMAN_DISPLAY_SSE2
+	if (scale == 2) {
+		for (; i + 8 <= n; i += 8) {
+			v = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(v, v));
+			_mm_storeu_si128((__m128i*)(dst + 8), _mm_unpackhi_epi16(v, v));
+			dst += 16;
+		}
+	}
+	else if (scale == 4) {
+		for (; i + 8 <= n; i += 8) {
+			v = _mm_loadu_si128((const __m128i*)(src + i));
+			lo = _mm_unpacklo_epi16(v, v);
+			hi = _mm_unpackhi_epi16(v, v);
+			_mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(lo, lo));
+			_mm_storeu_si128((__m128i*)(dst + 8), _mm_unpackhi_epi32(lo, lo));
+			_mm_storeu_si128((__m128i*)(dst + 16), _mm_unpacklo_epi32(hi, hi));
+			_mm_storeu_si128((__m128i*)(dst + 24), _mm_unpackhi_epi32(hi, hi));
+			dst += 32;
+		}
+	}
+#endif
+
+	for (; i < n; i++)
+		for (k = 0; k < scale; k++)
+			*dst++ = src[i];
+}
+
+
+
+/* Scale a block of w x h pixels. Each source row is spread out once, and
+ * the result copied to the rows below it. */
+static void sdlman_scale_pixels(Uint8* src, int src_pitch, Uint8* dst,
+	int dst_pitch, int bytes_per_pixel, int w, int h, int scale)
+{
+	int i, k, row_bytes;
+
+	row_bytes = w * scale * bytes_per_pixel;
+	for (i = 0; i < h; i++) {
+		if (bytes_per_pixel == 4)
+			sdlman_scale_row32((Uint32*)src, (Uint32*)dst, w, scale);
+		else
+			sdlman_scale_row16((Uint16*)src, (Uint16*)dst, w, scale);
+		for (k = 1; k < scale; k++)
+			memcpy(dst + (k * dst_pitch), dst, row_bytes);
+		src += src_pitch;
+		dst += dst_pitch * scale;
+	}
+}
+
+
+
+/* Copy a rectangle of the screen into the window, with the rectangle
+ * clipped to the screen and then scaled to window co-ordinates. */
+static void sdlman_display_scale(sdlman_display_t* d, SDL_Rect* r)
+{
+	int x, y, w, h, bpp;
+	Uint8* src, * dst;
+
+	x = (r->x < 0) ? 0 : r->x;
+	y = (r->y < 0) ? 0 : r->y;
+	w = r->x + r->w - x;
+	h = r->y + r->h - y;
+	if (x + w > d->screen->w)
+		w = d->screen->w - x;
+	if (y + h > d->screen->h)
+		h = d->screen->h - y;
+	if (w <= 0 || h <= 0) {
+		r->w = r->h = 0;
+		return;
+	}
+
+	bpp = d->screen->format->BytesPerPixel;
+	src = (Uint8*)d->screen->pixels + (y * d->screen->pitch) + (x * bpp);
+	dst = (Uint8*)d->window->pixels + (y * d->scale * d->window->pitch) +
+		(x * d->scale * bpp);
+	sdlman_scale_pixels(src, d->screen->pitch, dst, d->window->pitch, bpp,
+		w, h, d->scale);
+
+	r->x = x * d->scale;
+	r->y = y * d->scale;
+	r->w = w * d->scale;
+	r->h = h * d->scale;
+}
+
+
+
+/* Largest scale the desktop has room for, when asked to pick one. */
+static int sdlman_display_fit(void)
+{
+	int scale;
+	const SDL_VideoInfo* info;
+
+	info = SDL_GetVideoInfo();
+	if (info == NULL || info->current_w <= 0 || info->current_h <= 0)
+		return 1;
+
+	scale = SDLMAN_MAX_SCALE;
+	while (scale > 1 && (SDLMAN_DISPLAY_WIDTH * scale > info->current_w ||
+		SDLMAN_DISPLAY_HEIGHT * scale > info->current_h))
+		scale--;
+	return scale;
+}
+
+
+
+/* Open the window in the display's own pixel format if it has 16 or 32 bits
+ * per pixel, and in 32 bits otherwise, since SDL blits packed 24 bits and
+ * palettes slowly. The screen is double buffered in video memory if there
+ * is any, and all graphics are converted to its format when loaded.
+ *
+ * A scaled window is kept in system memory instead, so only what changed
+ * is scaled into it and updated, and everything is drawn at the native
+ * size into a screen surface of the same format. Scale 0 picks the largest
+ * one that fits the desktop. */
+int sdlman_display_open(sdlman_display_t* d, int scale)
+{
+	int bpp;
+	Uint32 flags;
+	const SDL_VideoInfo* info;
+	SDL_Surface* w;
+
+	if (scale == 0)
+		scale = sdlman_display_fit();
+	if (scale < 1 || scale > SDLMAN_MAX_SCALE) {
+		fprintf(stderr, "Error: Scale must be from 1 to %d.\n", SDLMAN_MAX_SCALE);
+		return -1;
+	}
+
+	bpp = 32;
+	flags = SDL_SWSURFACE;
+	info = SDL_GetVideoInfo();
+	if (info != NULL) {
+		if (info->vfmt->BitsPerPixel == 16 || info->vfmt->BitsPerPixel == 32)
+			bpp = info->vfmt->BitsPerPixel;
+		if (info->hw_available && scale == 1)
+			flags = SDL_HWSURFACE | SDL_DOUBLEBUF;
+	}
+
+	d->window = SDL_SetVideoMode(SDLMAN_DISPLAY_WIDTH * scale,
+		SDLMAN_DISPLAY_HEIGHT * scale, bpp, flags);
+	if (d->window == NULL && flags != SDL_SWSURFACE) {
+		fprintf(stderr, "Warning: Unable to use video memory: %s\n",
+			SDL_GetError());
+		d->window = SDL_SetVideoMode(SDLMAN_DISPLAY_WIDTH * scale,
+			SDLMAN_DISPLAY_HEIGHT * scale, bpp, SDL_SWSURFACE);
+	}
+	if (d->window == NULL) {
+		fprintf(stderr, "Error: Unable to set video mode: %s\n", SDL_GetError());
+		return -1;
+	}
+
+	w = d->window;
+	d->scale = scale;
+	d->capture = NULL;
+	d->screen = w;
+	if (scale > 1) {
+		d->screen = SDL_CreateRGBSurface(SDL_SWSURFACE, SDLMAN_DISPLAY_WIDTH,
+			SDLMAN_DISPLAY_HEIGHT, w->format->BitsPerPixel, w->format->Rmask,
+			w->format->Gmask, w->format->Bmask, w->format->Amask);
+		if (d->screen == NULL) {
+			fprintf(stderr, "Error: Unable to create screen surface: %s\n",
+				SDL_GetError());
+			return -1;
+		}
+	}
+
+	fprintf(stderr, "Info: Video mode is %d bits per pixel in %s memory%s",
+		w->format->BitsPerPixel, (w->flags & SDL_HWSURFACE) ? "video" : "system",
+		(w->flags & SDL_DOUBLEBUF) ? ", double buffered" : "");
+	if (scale > 1)
+		fprintf(stderr, ", scaled %d times", scale);
+	fprintf(stderr, ".\n");
+	return 0;
+}
+
+
+
+void sdlman_display_close(sdlman_display_t* d)
+{
+	if (d->capture != NULL)
+		sdlman_capture_close(d->capture);
+	d->capture = NULL;
+	if (d->screen != d->window)
+		SDL_FreeSurface(d->screen);
+	d->screen = d->window = NULL;
+}
+
+
+
+static void sdlman_display_show(sdlman_display_t* d, int count,
+	SDL_Rect* rects)
+{
+	int i;
+
+	if (d->scale > 1) {
+		if (SDL_MUSTLOCK(d->window) && SDL_LockSurface(d->window) != 0)
+			return;
+		for (i = 0; i < count; i++)
+			sdlman_display_scale(d, &rects[i]);
+		if (SDL_MUSTLOCK(d->window))
+			SDL_UnlockSurface(d->window);
+	}
+
+	SDL_UpdateRects(d->window, count, rects);
+}
+
+
+
+/* Show parts of the screen. Rectangles are changed to the window area. */
+void sdlman_display_update(sdlman_display_t* d, int count, SDL_Rect* rects)
+{
+	if (d->capture != NULL)
+		sdlman_capture_frame(d->capture, d->screen);
+	sdlman_display_show(d, count, rects);
+}
+
+
+
+/* Show all of the screen. */
+void sdlman_display_flip(sdlman_display_t* d)
+{
+	SDL_Rect r;
+
+	if (d->capture != NULL)
+		sdlman_capture_frame(d->capture, d->screen);
+
+	if (d->scale == 1) {
+		SDL_Flip(d->window);
+		return;
+	}
+
+	r.x = 0;
+	r.y = 0;
+	r.w = SDLMAN_DISPLAY_WIDTH;
+	r.h = SDLMAN_DISPLAY_HEIGHT;
+	sdlman_display_show(d, 1, &r);
+}
+
+
+
+/* Time scaling whole frames, the worst case for a loop cycle, at every
+ * scale and pixel size. */
+int sdlman_scale_bench(void)
+{
+	int i, scale, bpp;
+	Uint8* src, * dst;
+	Uint64 start, us;
+
+	src = (Uint8*)malloc(SDLMAN_DISPLAY_WIDTH * SDLMAN_DISPLAY_HEIGHT * 4);
+	dst = (Uint8*)malloc(SDLMAN_DISPLAY_WIDTH * SDLMAN_DISPLAY_HEIGHT * 4 *
+		SDLMAN_MAX_SCALE * SDLMAN_MAX_SCALE);
+	if (src == NULL || dst == NULL) {
+		fprintf(stderr, "Error: Unable to allocate scale bench.\n");
+		free(src);
+		free(dst);
+		return -1;
+	}
+	for (i = 0; i < SDLMAN_DISPLAY_WIDTH * SDLMAN_DISPLAY_HEIGHT * 4; i++)
+		src[i] = (Uint8)rand();
+
+	for (bpp = 2; bpp <= 4; bpp += 2) {
+		for (scale = 2; scale <= SDLMAN_MAX_SCALE; scale++) {
+			start = sdlman_timer_us();
+			for (i = 0; i < SDLMAN_SCALE_BENCH_RUNS; i++)
+				sdlman_scale_pixels(src, SDLMAN_DISPLAY_WIDTH * bpp, dst,
+					SDLMAN_DISPLAY_WIDTH * bpp * scale, bpp, SDLMAN_DISPLAY_WIDTH,
+					SDLMAN_DISPLAY_HEIGHT, scale);
+			us = sdlman_timer_us() - start;
+			printf("%d bits, %d times: %.3f ms per frame.\n", bpp * 8, scale,
+				(double)us / SDLMAN_SCALE_BENCH_RUNS / 1000.0);
+		}
+	}
+	printf("(%s)\n",
+#ifdef SDLMAN_DISPLAY_SSE2
+		"SSE2"
+#else
+		"scalar"
+#endif
+	);
+
+	free(src);
+	free(dst);
+	return 0;
+}
@@ -0,0 +1,225 @@
+/* SDL-Man (Observation Encoder)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memset(). */
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SDLMAN_ENCODE_SSE2
+#include <emmintrin.h> /* For 128-bit byte compares. */
+#endif
+
+
+
+/* Local definitions. */
+#define SDLMAN_ENCODE_BENCH_RUNS 100000
+
+
+
+/* Rows of a plane from the world, ON where the tile is c and 0 elsewhere.
+ * A row is done as two overlapping 16 byte halves when it is wide enough. */
+static void sdlman_encode_match(unsigned char* plane, int row_stride,
+	char* world, char c)
+{
+	int y;
+	char* row;
+	unsigned char* out;
+#if defined(SDLMAN_ENCODE_SSE2) && SDLMAN_WORLD_X_SIZE >= 16
+	__m128i match;
+
+	match = _mm_set1_epi8(c);
+	for (y = 0; y < SDLMAN_WORLD_Y_SIZE; y++) {
+		row = world + (y * SDLMAN_WORLD_X_SIZE);
+		out = plane + (y * row_stride);
+		_mm_storeu_si128((__m128i*)out, _mm_cmpeq_epi8(match,
+			_mm_loadu_si128((__m128i*)row)));
+		_mm_storeu_si128((__m128i*)(out + SDLMAN_WORLD_X_SIZE - 16),
+			_mm_cmpeq_epi8(match,
+				_mm_loadu_si128((__m128i*)(row + SDLMAN_WORLD_X_SIZE - 16))));
+	}
+#else
+	int x;
+
+	for (y = 0; y < SDLMAN_WORLD_Y_SIZE; y++) {
+		row = world + (y * SDLMAN_WORLD_X_SIZE);
+		out = plane + (y * row_stride);
+		for (x = 0; x < SDLMAN_WORLD_X_SIZE; x++)
+			out[x] = (row[x] == c) ? SDLMAN_ENCODE_ON : 0;
+	}
+#endif
+}
+
+
+
+static void sdlman_encode_fill(unsigned char* plane, int row_stride,
+	unsigned char value)
+{
+	int y;
+
+	if (row_stride == SDLMAN_WORLD_X_SIZE) {
+		memset(plane, value, SDLMAN_WORLD_TILES);
+		return;
+	}
+	for (y = 0; y < SDLMAN_WORLD_Y_SIZE; y++)
+		memset(plane + (y * row_stride), value, SDLMAN_WORLD_X_SIZE);
+}
+
+
+
+static unsigned char* sdlman_encode_cell(unsigned char* plane, int row_stride,
+	int tile)
+{
+	return plane + ((tile / SDLMAN_WORLD_X_SIZE) * row_stride) +
+		(tile % SDLMAN_WORLD_X_SIZE);
+}
+
+
+
+/* Encode a game as SDLMAN_ENCODE_PLANES planes of bytes, in the order of
+ * the SDLMAN_PLANE_* values. Strides are in bytes, and rows must be at
+ * least SDLMAN_WORLD_X_SIZE apart. */
+void sdlman_encode(sdlman_game_t* g, unsigned char* out, int plane_stride,
+	int row_stride)
+{
+	int i, tile;
+	unsigned char* plane;
+
+	/* The layout still has every pellet, take away the eaten ones. */
+	sdlman_encode_match(out + (SDLMAN_PLANE_WALL * plane_stride), row_stride,
+		g->world, SDLMAN_WORLD_WALL);
+	sdlman_encode_match(out + (SDLMAN_PLANE_PELLET * plane_stride), row_stride,
+		g->world, SDLMAN_WORLD_PELLET);
+	sdlman_encode_match(out + (SDLMAN_PLANE_BOOSTER * plane_stride), row_stride,
+		g->world, SDLMAN_WORLD_BOOSTER);
+	for (i = 0; i < g->total_pellets; i++) {
+		if (!g->pellet[i].consumed)
+			continue;
+		if (g->pellet[i].boost_effect)
+			plane = out + (SDLMAN_PLANE_BOOSTER * plane_stride);
+		else
+			plane = out + (SDLMAN_PLANE_PELLET * plane_stride);
+		tile = ((g->pellet[i].y / SDLMAN_BLOCK_SIZE) * SDLMAN_WORLD_X_SIZE) +
+			(g->pellet[i].x / SDLMAN_BLOCK_SIZE);
+		*sdlman_encode_cell(plane, row_stride, tile) = 0;
+	}
+
+	/* One tile for each character, none for killed enemies. */
+	plane = out + (SDLMAN_PLANE_PLAYER * plane_stride);
+	sdlman_encode_fill(plane, row_stride, 0);
+	*sdlman_encode_cell(plane, row_stride, sdlman_character_tile(&g->player)) =
+		SDLMAN_ENCODE_ON;
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		plane = out + ((SDLMAN_PLANE_ENEMY + i) * plane_stride);
+		sdlman_encode_fill(plane, row_stride, 0);
+		if (!g->enemy[i].killed)
+			*sdlman_encode_cell(plane, row_stride,
+				sdlman_character_tile(&g->enemy[i])) = SDLMAN_ENCODE_ON;
+	}
+
+	/* Booster time left, scaled so a fresh booster is ON. */
+	sdlman_encode_fill(out + (SDLMAN_PLANE_FRIGHTENED * plane_stride),
+		row_stride, (unsigned char)((g->booster_time * SDLMAN_ENCODE_ON) /
+			SDLMAN_BOOSTER_TIME));
+}
+
+
+
+/* Encode count games into a batch, game n at out + (n * batch_stride). */
+void sdlman_encode_batch(sdlman_game_t** g, int count, unsigned char* out,
+	int batch_stride, int plane_stride, int row_stride)
+{
+	int n;
+
+	for (n = 0; n < count; n++)
+		sdlman_encode(g[n], out + ((size_t)n * batch_stride), plane_stride,
+			row_stride);
+}
+
+
+
+/* Compare the cost of encoding against a loop cycle, on a world played at
+ * random. */
+int sdlman_encode_bench(char* world_layout_file)
+{
+	int i;
+	char world[SDLMAN_WORLD_TILES];
+	unsigned char* planes;
+	Uint64 start, step_us, encode_us;
+	sdlman_game_t* g, * copy;
+
+	if (sdlman_game_load_world(world_layout_file, world) != 0)
+		return -1;
+
+	g = (sdlman_game_t*)malloc(sizeof(sdlman_game_t));
+	copy = (sdlman_game_t*)malloc(sizeof(sdlman_game_t));
+	planes = (unsigned char*)malloc(SDLMAN_ENCODE_PLANES * SDLMAN_WORLD_TILES);
+	if (g == NULL || copy == NULL || planes == NULL) {
+		fprintf(stderr, "Error: Unable to allocate encoder bench.\n");
+		free(g);
+		free(copy);
+		free(planes);
+		return -1;
+	}
+
+	if (sdlman_game_init(g, world, 5, (unsigned int)rand()) != 0) {
+		free(g);
+		free(copy);
+		free(planes);
+		return -1;
+	}
+	g->ai.budget_us = 0;
+	sdlman_game_step(g); /* Fills in the path table. */
+
+	/* Random play, the way a trainer would step. */
+	sdlman_game_clone(copy, g);
+	start = sdlman_timer_us();
+	for (i = 0; i < SDLMAN_ENCODE_BENCH_RUNS; i++) {
+		if (copy->status != SDLMAN_GAME_RUNNING)
+			sdlman_game_clone(copy, g);
+		if (sdlman_character_aligned(&copy->player))
+			sdlman_game_input(copy, (sdlman_game_random(copy) % 4) + 1);
+		sdlman_game_step(copy);
+	}
+	step_us = sdlman_timer_us() - start;
+
+	/* Wherever the random play ended up. */
+	start = sdlman_timer_us();
+	for (i = 0; i < SDLMAN_ENCODE_BENCH_RUNS; i++)
+		sdlman_encode(copy, planes, SDLMAN_WORLD_TILES, SDLMAN_WORLD_X_SIZE);
+	encode_us = sdlman_timer_us() - start;
+
+	printf("%.3f us per loop cycle, %.3f us per encode (%s).\n",
+		(double)step_us / SDLMAN_ENCODE_BENCH_RUNS,
+		(double)encode_us / SDLMAN_ENCODE_BENCH_RUNS,
+#ifdef SDLMAN_ENCODE_SSE2
+		"SSE2"
+#else
+		"scalar"
+#endif
+	);
+
+	sdlman_game_free(g);
+	free(g);
+	free(copy);
+	free(planes);
+	return 0;
+}
@@ -0,0 +1,224 @@
+/* SDL-Man (Environment)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memset(). */
+
+
+
+/* Environment writing into obs, which must be aligned to SDLMAN_ENV_ALIGN
+ * and stay around for as long as the environment. NULL for an observation
+ * buffer of its own. */
+sdlman_env_t* sdlman_env_create(sdlman_env_obs_t* obs)
+{
+	sdlman_env_t* env;
+
+	if (obs != NULL && ((size_t)obs % SDLMAN_ENV_ALIGN) != 0) {
+		fprintf(stderr, "Error: Observation buffer not aligned to %d bytes.\n",
+			SDLMAN_ENV_ALIGN);
+		return NULL;
+	}
+
+	env = (sdlman_env_t*)malloc(sizeof(sdlman_env_t));
+	if (env == NULL) {
+		fprintf(stderr, "Error: Unable to allocate environment.\n");
+		return NULL;
+	}
+
+	env->own_obs = NULL;
+	if (obs == NULL) {
+		env->own_obs = (unsigned char*)malloc(sizeof(sdlman_env_obs_t) +
+			SDLMAN_ENV_ALIGN);
+		if (env->own_obs == NULL) {
+			fprintf(stderr, "Error: Unable to allocate environment.\n");
+			free(env);
+			return NULL;
+		}
+		obs = (sdlman_env_obs_t*)(env->own_obs + SDLMAN_ENV_ALIGN -
+			((size_t)env->own_obs % SDLMAN_ENV_ALIGN));
+	}
+
+	env->obs = obs;
+	env->loaded = 0;
+	sdlman_reserve_search_init(&env->search);
+	memset(obs, 0, sizeof(sdlman_env_obs_t));
+
+	return env;
+}
+
+
+
+void sdlman_env_destroy(sdlman_env_t* env)
+{
+	if (env == NULL)
+		return;
+	if (env->loaded)
+		sdlman_game_free(&env->game);
+	free(env->own_obs);
+	free(env);
+}
+
+
+
+static void sdlman_env_entity(sdlman_env_obs_t* obs, int n,
+	sdlman_character_t* c)
+{
+	obs->x[n] = c->x;
+	obs->y[n] = c->y;
+	if (c->moving_direction == SDLMAN_DIRECTION_NONE)
+		obs->direction[n] = c->looking_direction;
+	else
+		obs->direction[n] = c->moving_direction;
+	obs->killed[n] = c->killed;
+}
+
+
+
+/* Bring the observation up to date, only touching pellets if any were
+ * eaten since last time. */
+static void sdlman_env_observe(sdlman_env_t* env, int eaten)
+{
+	int i, tile;
+	sdlman_env_obs_t* obs;
+	sdlman_game_t* g;
+
+	obs = env->obs;
+	g = &env->game;
+
+	if (eaten) {
+		for (i = 0; i < g->total_pellets; i++) {
+			if (!g->pellet[i].consumed)
+				continue;
+			tile = env->pellet_tile[i];
+			obs->pellet[tile / 32] &= ~((Uint32)1 << (tile % 32));
+			obs->booster[tile / 32] &= ~((Uint32)1 << (tile % 32));
+		}
+	}
+
+	sdlman_env_entity(obs, 0, &g->player);
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++)
+		sdlman_env_entity(obs, i + 1, &g->enemy[i]);
+	obs->booster_time = g->booster_time;
+	obs->status = g->status;
+	obs->tick = (int)g->ai.tick;
+}
+
+
+
+/* Start a new game of a loaded world. With paths, the complete path table
+ * of that world is shared and nothing is allocated. */
+int sdlman_env_start(sdlman_env_t* env, char* world, int enemy_speed,
+	unsigned int seed, sdlman_path_table_t* paths)
+{
+	int i, tile;
+	sdlman_env_obs_t* obs;
+	sdlman_game_t* g;
+
+	g = &env->game;
+	if (env->loaded)
+		sdlman_game_free(g);
+	env->loaded = 0;
+	if (paths == NULL) {
+		if (sdlman_game_init(g, world, enemy_speed, seed) != 0)
+			return -1;
+	}
+	else {
+		if (sdlman_game_reset(g, world, enemy_speed, seed, paths,
+			&env->search) != 0)
+			return -1;
+	}
+	env->loaded = 1;
+	g->ai.budget_us = 0; /* Same seed, same game. */
+	env->points = 0;
+
+	obs = env->obs;
+	memset(obs->pellet, 0, sizeof(obs->pellet));
+	memset(obs->booster, 0, sizeof(obs->booster));
+	for (i = 0; i < g->total_pellets; i++) {
+		tile = ((g->pellet[i].y / SDLMAN_BLOCK_SIZE) * SDLMAN_WORLD_X_SIZE) +
+			(g->pellet[i].x / SDLMAN_BLOCK_SIZE);
+		env->pellet_tile[i] = tile;
+		if (g->pellet[i].boost_effect)
+			obs->booster[tile / 32] |= (Uint32)1 << (tile % 32);
+		else
+			obs->pellet[tile / 32] |= (Uint32)1 << (tile % 32);
+	}
+	for (i = 0; i < SDLMAN_WORLD_TILES; i++)
+		obs->wall[i] = (g->world[i] == SDLMAN_WORLD_WALL);
+	obs->reward = 0;
+	sdlman_env_observe(env, 0);
+
+	return 0;
+}
+
+
+
+/* Start a new game of a world, with everything random taken from seed. */
+int sdlman_env_reset(sdlman_env_t* env, unsigned int seed, int world_number,
+	int enemy_speed)
+{
+	char layout_file[SDLMAN_FILENAME_LENGTH];
+	char world[SDLMAN_WORLD_TILES];
+
+	if (world_number < 1 || world_number > SDLMAN_MAX_WORLD ||
+		enemy_speed < 1 || enemy_speed > SDLMAN_MAX_ENEMY_SPEED) {
+		fprintf(stderr, "Error: No world %d with enemy speed %d.\n",
+			world_number, enemy_speed);
+		return -1;
+	}
+
+	snprintf(layout_file, SDLMAN_FILENAME_LENGTH, "world%d.layout",
+		world_number);
+	if (sdlman_game_load_world(layout_file, world) != 0)
+		return -1;
+
+	return sdlman_env_start(env, world, enemy_speed, seed, NULL);
+}
+
+
+
+/* One loop cycle with the player pressing action, a direction or none for
+ * no key. Returns the reward, in unscaled score points. Finished games
+ * stay as they are until reset. */
+int sdlman_env_step(sdlman_env_t* env, int action)
+{
+	int events, points;
+	sdlman_game_t* g;
+
+	g = &env->game;
+	if (!env->loaded || g->status != SDLMAN_GAME_RUNNING) {
+		env->obs->reward = 0;
+		return 0;
+	}
+
+	if (action < SDLMAN_DIRECTION_NONE || action > SDLMAN_DIRECTION_RIGHT)
+		action = SDLMAN_DIRECTION_NONE;
+	sdlman_game_input(g, action);
+	events = sdlman_game_step(g);
+
+	points = g->bonus + (g->consumed * SDLMAN_SCORE_PELLET);
+	env->obs->reward = points - env->points;
+	env->points = points;
+	sdlman_env_observe(env, events & SDLMAN_GAME_CHOMP);
+
+	return env->obs->reward;
+}
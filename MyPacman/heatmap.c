@@ -0,0 +1,224 @@
+/* SDL-Man (Heatmap)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+/* Local definitions. */
+#define SDLMAN_HEATMAP_LAYERS (SDLMAN_HEATMAP_CHARACTERS + 1) /* And deaths. */
+#define SDLMAN_HEATMAP_SCALE 8 /* Pixels per tile in images. */
+#define SDLMAN_HEATMAP_WALL 0 /* Grey levels in images. */
+#define SDLMAN_HEATMAP_UNSEEN 32
+#define SDLMAN_HEATMAP_LOWEST 64
+
+
+
+sdlman_heatmap_t* sdlman_heatmap_create(void)
+{
+	sdlman_heatmap_t* h;
+
+	h = (sdlman_heatmap_t*)calloc(1, sizeof(sdlman_heatmap_t));
+	if (h == NULL)
+		fprintf(stderr, "Error: Unable to allocate heatmap.\n");
+
+	return h;
+}
+
+
+
+void sdlman_heatmap_destroy(sdlman_heatmap_t* h)
+{
+	free(h);
+}
+
+
+
+/* Count the tiles entered since the last step, called by the game after
+ * every step. The first call of a game counts the starting tiles. */
+void sdlman_heatmap_update(sdlman_heatmap_t* h, sdlman_game_t* g)
+{
+	int i, tile;
+
+	if (g->heat_tile[0] == -1)
+		h->games++;
+
+	tile = sdlman_character_tile(&g->player);
+	if (tile != g->heat_tile[0]) {
+		h->visits[0][tile]++;
+		g->heat_tile[0] = tile;
+	}
+	if (g->status == SDLMAN_GAME_KILLED)
+		h->deaths[tile]++;
+
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		if (g->enemy[i].killed)
+			continue;
+		tile = sdlman_character_tile(&g->enemy[i]);
+		if (tile != g->heat_tile[i + 1]) {
+			h->visits[i + 1][tile]++;
+			g->heat_tile[i + 1] = tile;
+		}
+	}
+}
+
+
+
+/* Add the counts of one heatmap to another, like those of worker threads. */
+void sdlman_heatmap_merge(sdlman_heatmap_t* dst, sdlman_heatmap_t* src)
+{
+	int i, j;
+
+	for (i = 0; i < SDLMAN_HEATMAP_CHARACTERS; i++) {
+		for (j = 0; j < SDLMAN_WORLD_TILES; j++)
+			dst->visits[i][j] += src->visits[i][j];
+	}
+	for (j = 0; j < SDLMAN_WORLD_TILES; j++)
+		dst->deaths[j] += src->deaths[j];
+	dst->games += src->games;
+}
+
+
+
+static unsigned int* sdlman_heatmap_layer(sdlman_heatmap_t* h, int layer)
+{
+	if (layer < SDLMAN_HEATMAP_CHARACTERS)
+		return h->visits[layer];
+	return h->deaths;
+}
+
+
+
+/* Write the counts as a binary grid: width, height, layers and games, then
+ * the player, enemy and death layers of width by height counts, row by
+ * row, all as 32-bit little endian numbers. */
+int sdlman_heatmap_write(sdlman_heatmap_t* h, char* filename)
+{
+	int i, j, k;
+	unsigned int value, header[4];
+	unsigned int* layer;
+	unsigned char bytes[4];
+	FILE* fh;
+
+	fh = fopen(filename, "wb");
+	if (fh == NULL) {
+		fprintf(stderr, "Error: Cannot open file '%s' for writing.\n", filename);
+		return -1;
+	}
+
+	header[0] = SDLMAN_WORLD_X_SIZE;
+	header[1] = SDLMAN_WORLD_Y_SIZE;
+	header[2] = SDLMAN_HEATMAP_LAYERS;
+	header[3] = h->games;
+	for (i = 0; i < 4; i++) {
+		for (k = 0; k < 4; k++)
+			bytes[k] = (unsigned char)(header[i] >> (k * 8));
+		fwrite(bytes, 1, 4, fh);
+	}
+
+	for (i = 0; i < SDLMAN_HEATMAP_LAYERS; i++) {
+		layer = sdlman_heatmap_layer(h, i);
+		for (j = 0; j < SDLMAN_WORLD_TILES; j++) {
+			value = layer[j];
+			for (k = 0; k < 4; k++)
+				bytes[k] = (unsigned char)(value >> (k * 8));
+			fwrite(bytes, 1, 4, fh);
+		}
+	}
+
+	if (fclose(fh) != 0) {
+		fprintf(stderr, "Error: Unable to write file '%s'.\n", filename);
+		return -1;
+	}
+	return 0;
+}
+
+
+
+/* Write the counts as a greyscale PGM image, with the player, each enemy
+ * and the deaths side by side. Each layer is scaled to its own highest
+ * count, walls are black and tiles never entered are dark grey. */
+int sdlman_heatmap_write_pgm(sdlman_heatmap_t* h, char* world,
+	char* filename)
+{
+	int i, x, y, tile, width, height;
+	unsigned int highest[SDLMAN_HEATMAP_LAYERS];
+	unsigned int* layer;
+	unsigned char* row;
+	unsigned char grey;
+	FILE* fh;
+
+	/* A tile wide gap between layers. */
+	width = (SDLMAN_HEATMAP_LAYERS * (SDLMAN_WORLD_X_SIZE + 1) - 1) *
+		SDLMAN_HEATMAP_SCALE;
+	height = SDLMAN_WORLD_Y_SIZE * SDLMAN_HEATMAP_SCALE;
+
+	row = (unsigned char*)malloc(width);
+	if (row == NULL) {
+		fprintf(stderr, "Error: Unable to allocate heatmap image row.\n");
+		return -1;
+	}
+	fh = fopen(filename, "wb");
+	if (fh == NULL) {
+		fprintf(stderr, "Error: Cannot open file '%s' for writing.\n", filename);
+		free(row);
+		return -1;
+	}
+	fprintf(fh, "P5\n# %u games\n%d %d\n255\n", h->games, width, height);
+
+	for (i = 0; i < SDLMAN_HEATMAP_LAYERS; i++) {
+		layer = sdlman_heatmap_layer(h, i);
+		highest[i] = 0;
+		for (tile = 0; tile < SDLMAN_WORLD_TILES; tile++) {
+			if (layer[tile] > highest[i])
+				highest[i] = layer[tile];
+		}
+	}
+
+	for (y = 0; y < height; y++) {
+		memset(row, SDLMAN_HEATMAP_WALL, width);
+		for (i = 0; i < SDLMAN_HEATMAP_LAYERS; i++) {
+			layer = sdlman_heatmap_layer(h, i);
+			for (x = 0; x < SDLMAN_WORLD_X_SIZE * SDLMAN_HEATMAP_SCALE; x++) {
+				tile = ((y / SDLMAN_HEATMAP_SCALE) * SDLMAN_WORLD_X_SIZE) +
+					(x / SDLMAN_HEATMAP_SCALE);
+				if (world[tile] == SDLMAN_WORLD_WALL)
+					grey = SDLMAN_HEATMAP_WALL;
+				else if (layer[tile] == 0)
+					grey = SDLMAN_HEATMAP_UNSEEN;
+				else
+					grey = (unsigned char)(SDLMAN_HEATMAP_LOWEST +
+						((255 - SDLMAN_HEATMAP_LOWEST) * (double)layer[tile]) /
+						highest[i]);
+				row[(i * (SDLMAN_WORLD_X_SIZE + 1) * SDLMAN_HEATMAP_SCALE) + x] = grey;
+			}
+		}
+		fwrite(row, 1, width, fh);
+	}
+
+	free(row);
+	if (fclose(fh) != 0) {
+		fprintf(stderr, "Error: Unable to write file '%s'.\n", filename);
+		return -1;
+	}
+	return 0;
+}
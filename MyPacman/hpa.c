@@ -0,0 +1,1562 @@
+/* SDL-Man (Hierarchical Path Finding)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+/* Local definitions. */
+#define SDLMAN_HPA_LONG_ENTRANCE 6 /* Longer gets a transition at both ends. */
+#define SDLMAN_HPA_REGION 4 /* Clusters along each side of a region. */
+#define SDLMAN_HPA_NO_HOP 0xffff /* Gate not reachable inside the region. */
+#define SDLMAN_HPA_GREED 4 /* Estimates count 1/16 more between gates. */
+#define SDLMAN_HPA_CACHE_MIN 4096 /* Entries, power of two. */
+#define SDLMAN_HPA_CACHE_MAX 1048576
+#define SDLMAN_HPA_CACHE_PER_NODE 16
+#define SDLMAN_HPA_INFINITY 0x3fffffff
+
+#define SDLMAN_HPA_STRESS_CLUSTER 16
+#define SDLMAN_HPA_STRESS_QUERIES 1000
+#define SDLMAN_HPA_STRESS_WALKS 20
+#define SDLMAN_HPA_STRESS_PASSES 3 /* Fastest kept, so preemption is not counted. */
+#define SDLMAN_HPA_STRESS_LIMIT 1000 /* Microseconds allowed for any query. */
+#define SDLMAN_HPA_STRESS_LOOPS 10 /* Percent of walls knocked down. */
+
+
+
+/* Temporary edge list while building the abstract graph. */
+typedef struct sdlman_hpa_build_s {
+	int node_alloc;
+	int* from;
+	sdlman_hpa_edge_t* edge;
+	int edges, edge_alloc;
+} sdlman_hpa_build_t;
+
+
+
+/* Manhattan distance, taking wrapping around the edges into account. */
+static int sdlman_hpa_heuristic(sdlman_hpa_t* h, int a, int b)
+{
+	int dx, dy;
+
+	dx = abs((a % h->width) - (b % h->width));
+	dy = abs((a / h->width) - (b / h->width));
+	if (h->width - dx < dx)
+		dx = h->width - dx;
+	if (h->height - dy < dy)
+		dy = h->height - dy;
+
+	return dx + dy;
+}
+
+
+
+static int sdlman_hpa_cluster(sdlman_hpa_t* h, int tile)
+{
+	return ((tile / h->width / h->cluster_size) * h->clusters_x) +
+		((tile % h->width) / h->cluster_size);
+}
+
+
+
+static int sdlman_hpa_region(sdlman_hpa_t* h, int tile)
+{
+	return ((tile / h->width / h->region_size) * h->regions_x) +
+		((tile % h->width) / h->region_size);
+}
+
+
+
+/* Index of tile inside its own cluster. */
+static int sdlman_hpa_local(sdlman_hpa_t* h, int tile)
+{
+	return (((tile / h->width) % h->cluster_size) * h->cluster_size) +
+		((tile % h->width) % h->cluster_size);
+}
+
+
+
+/* Breadth first search from tile, without leaving its cluster. */
+static void sdlman_hpa_local_search(sdlman_hpa_t* h, int tile)
+{
+	int i, x, y, x0, y0, x1, y1, n, head, tail, local;
+
+	x0 = ((tile % h->width) / h->cluster_size) * h->cluster_size;
+	y0 = ((tile / h->width) / h->cluster_size) * h->cluster_size;
+	x1 = x0 + h->cluster_size;
+	y1 = y0 + h->cluster_size;
+	if (x1 > h->width)
+		x1 = h->width;
+	if (y1 > h->height)
+		y1 = h->height;
+
+	for (i = 0; i < h->cluster_size * h->cluster_size; i++)
+		h->local_distance[i] = -1;
+
+	head = tail = 0;
+	h->local_distance[sdlman_hpa_local(h, tile)] = 0;
+	h->local_queue[tail++] = tile;
+
+	while (head < tail) {
+		tile = h->local_queue[head++];
+		local = sdlman_hpa_local(h, tile);
+		x = tile % h->width;
+		y = tile / h->width;
+
+		for (i = 0; i < 4; i++) {
+			switch (i) {
+			case 0:
+				n = (y > y0) ? tile - h->width : -1;
+				break;
+			case 1:
+				n = (y < y1 - 1) ? tile + h->width : -1;
+				break;
+			case 2:
+				n = (x > x0) ? tile - 1 : -1;
+				break;
+			default:
+				n = (x < x1 - 1) ? tile + 1 : -1;
+				break;
+			}
+			if (n == -1 || h->world[n] == SDLMAN_WORLD_WALL)
+				continue;
+			if (h->local_distance[sdlman_hpa_local(h, n)] != -1)
+				continue;
+			h->local_distance[sdlman_hpa_local(h, n)] = h->local_distance[local] + 1;
+			h->local_queue[tail++] = n;
+		}
+	}
+}
+
+
+
+/* Equal keys go by the highest tie first, for A* the cost so far makes
+ * that the node nearest the goal. */
+static void sdlman_hpa_push(sdlman_hpa_t* h, int key, int tie, int node)
+{
+	int i, parent;
+
+	i = h->heap_size++;
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (h->heap_key[parent] < key ||
+			(h->heap_key[parent] == key && h->heap_tie[parent] >= tie))
+			break;
+		h->heap_key[i] = h->heap_key[parent];
+		h->heap_tie[i] = h->heap_tie[parent];
+		h->heap_node[i] = h->heap_node[parent];
+		i = parent;
+	}
+	h->heap_key[i] = key;
+	h->heap_tie[i] = tie;
+	h->heap_node[i] = node;
+}
+
+
+
+static void sdlman_hpa_pop(sdlman_hpa_t* h, int* key, int* node)
+{
+	int i, child, last_key, last_tie, last_node;
+
+	*key = h->heap_key[0];
+	*node = h->heap_node[0];
+
+	h->heap_size--;
+	last_key = h->heap_key[h->heap_size];
+	last_tie = h->heap_tie[h->heap_size];
+	last_node = h->heap_node[h->heap_size];
+
+	i = 0;
+	while ((child = (i * 2) + 1) < h->heap_size) {
+		if (child + 1 < h->heap_size && (h->heap_key[child + 1] < h->heap_key[child] ||
+			(h->heap_key[child + 1] == h->heap_key[child] &&
+			h->heap_tie[child + 1] > h->heap_tie[child])))
+			child++;
+		if (last_key < h->heap_key[child] ||
+			(last_key == h->heap_key[child] && last_tie >= h->heap_tie[child]))
+			break;
+		h->heap_key[i] = h->heap_key[child];
+		h->heap_tie[i] = h->heap_tie[child];
+		h->heap_node[i] = h->heap_node[child];
+		i = child;
+	}
+	h->heap_key[i] = last_key;
+	h->heap_tie[i] = last_tie;
+	h->heap_node[i] = last_node;
+}
+
+
+
+static int sdlman_hpa_add_node(sdlman_hpa_t* h, sdlman_hpa_build_t* b,
+	int tile)
+{
+	sdlman_hpa_node_t* node;
+
+	if (h->node_of_tile[tile] != -1)
+		return h->node_of_tile[tile];
+
+	if (h->nodes == b->node_alloc) {
+		node = (sdlman_hpa_node_t*)realloc(h->node,
+			sizeof(sdlman_hpa_node_t) * b->node_alloc * 2);
+		if (node == NULL)
+			return -1;
+		h->node = node;
+		b->node_alloc *= 2;
+	}
+
+	h->node[h->nodes].tile = tile;
+	h->node[h->nodes].cluster = sdlman_hpa_cluster(h, tile);
+	h->node[h->nodes].region = sdlman_hpa_region(h, tile);
+	h->node_of_tile[tile] = h->nodes;
+
+	return h->nodes++;
+}
+
+
+
+static int sdlman_hpa_add_edge(sdlman_hpa_build_t* b, int from, int to,
+	int cost)
+{
+	int* f;
+	sdlman_hpa_edge_t* e;
+
+	if (b->edges == b->edge_alloc) {
+		f = (int*)realloc(b->from, sizeof(int) * b->edge_alloc * 2);
+		if (f == NULL)
+			return -1;
+		b->from = f;
+		e = (sdlman_hpa_edge_t*)realloc(b->edge,
+			sizeof(sdlman_hpa_edge_t) * b->edge_alloc * 2);
+		if (e == NULL)
+			return -1;
+		b->edge = e;
+		b->edge_alloc *= 2;
+	}
+
+	b->from[b->edges] = from;
+	b->edge[b->edges].to = to;
+	b->edge[b->edges].cost = cost;
+	b->edges++;
+
+	return 0;
+}
+
+
+
+static int sdlman_hpa_add_transition(sdlman_hpa_t* h, sdlman_hpa_build_t* b,
+	int t1, int t2)
+{
+	int n1, n2;
+
+	if ((n1 = sdlman_hpa_add_node(h, b, t1)) == -1)
+		return -1;
+	if ((n2 = sdlman_hpa_add_node(h, b, t2)) == -1)
+		return -1;
+	if (sdlman_hpa_add_edge(b, n1, n2, 1) != 0)
+		return -1;
+	return sdlman_hpa_add_edge(b, n2, n1, 1);
+}
+
+
+
+/* Find entrances along a border of length tiles, where t1 and t2 are the
+ * first tiles on each side and step goes along the border. */
+static int sdlman_hpa_add_entrances(sdlman_hpa_t* h, sdlman_hpa_build_t* b,
+	int t1, int t2, int step, int length)
+{
+	int i, start, open;
+
+	start = -1;
+	for (i = 0; i <= length; i++) {
+		open = (i < length) &&
+			h->world[t1 + (i * step)] != SDLMAN_WORLD_WALL &&
+			h->world[t2 + (i * step)] != SDLMAN_WORLD_WALL;
+
+		if (open && start == -1)
+			start = i;
+
+		if (!open && start != -1) {
+			/* One transition in the middle, or one at each end if long. */
+			if (i - start < SDLMAN_HPA_LONG_ENTRANCE) {
+				if (sdlman_hpa_add_transition(h, b, t1 + (((start + i - 1) / 2) * step),
+					t2 + (((start + i - 1) / 2) * step)) != 0)
+					return -1;
+			}
+			else {
+				if (sdlman_hpa_add_transition(h, b, t1 + (start * step),
+					t2 + (start * step)) != 0)
+					return -1;
+				if (sdlman_hpa_add_transition(h, b, t1 + ((i - 1) * step),
+					t2 + ((i - 1) * step)) != 0)
+					return -1;
+			}
+			start = -1;
+		}
+	}
+
+	return 0;
+}
+
+
+
+/* Counting sort of the edges in b by which of count nodes they are from,
+ * the starts are shifted back into place afterwards. */
+static int sdlman_hpa_group(sdlman_hpa_build_t* b, int count, int** first,
+	sdlman_hpa_edge_t** edge)
+{
+	int i, n;
+
+	*first = (int*)malloc(sizeof(int) * (count + 1));
+	*edge = (sdlman_hpa_edge_t*)malloc(sizeof(sdlman_hpa_edge_t) * (b->edges + 1));
+	if (*first == NULL || *edge == NULL)
+		return -1;
+
+	for (n = 0; n <= count; n++)
+		(*first)[n] = 0;
+	for (i = 0; i < b->edges; i++)
+		(*first)[b->from[i] + 1]++;
+	for (n = 0; n < count; n++)
+		(*first)[n + 1] += (*first)[n];
+	for (i = 0; i < b->edges; i++)
+		(*edge)[(*first)[b->from[i]]++] = b->edge[i];
+	for (n = count; n > 0; n--)
+		(*first)[n] = (*first)[n - 1];
+	(*first)[0] = 0;
+
+	return 0;
+}
+
+
+
+/* Dijkstra from the nodes already pushed, without leaving region. Returns
+ * the entrance marked as goal that is cheapest to finish at, lowering best,
+ * or -1. Stops once nothing can beat best. */
+static int sdlman_hpa_region_search(sdlman_hpa_t* h, int region, int mark,
+	int* best)
+{
+	int i, n, m, key, cost, goal;
+
+	goal = -1;
+	while (h->heap_size > 0) {
+		sdlman_hpa_pop(h, &key, &n);
+		if (key >= *best)
+			break;
+		if (key != h->cost[n])
+			continue; /* Stale. */
+
+		if (h->goal_stamp[n] == mark && key + h->goal_cost[n] < *best) {
+			*best = key + h->goal_cost[n];
+			goal = n;
+		}
+
+		for (i = h->edge_first[n]; i < h->edge_first[n + 1]; i++) {
+			m = h->edge[i].to;
+			if (h->node[m].region != region)
+				continue;
+			cost = key + h->edge[i].cost;
+			if (h->stamp[m] == h->search && h->cost[m] <= cost)
+				continue;
+			h->stamp[m] = h->search;
+			h->cost[m] = cost;
+			h->parent[m] = n;
+			sdlman_hpa_push(h, cost, 0, m);
+		}
+	}
+
+	return goal;
+}
+
+
+
+/* Group the entrances by region with the gates first, and keep for every
+ * gate the next step towards it and the cost left from each entrance of its
+ * region. Gates are numbered region by region, and linked by their
+ * transitions to other regions and with those costs to the other gates of
+ * their region. */
+static int sdlman_hpa_build_regions(sdlman_hpa_t* h, sdlman_hpa_build_t* b)
+{
+	int i, j, k, r, n, m, g, base, size, table, total, best, regions;
+
+	regions = h->regions_x * h->regions_y;
+	h->region_first = (int*)malloc(sizeof(int) * (regions + 1));
+	h->gate_first = (int*)calloc(regions + 1, sizeof(int));
+	h->hop_first = (int*)malloc(sizeof(int) * (regions + 1));
+	h->region_node = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->slot = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->gate = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	if (h->region_first == NULL || h->gate_first == NULL ||
+		h->hop_first == NULL || h->region_node == NULL || h->slot == NULL ||
+		h->gate == NULL)
+		return -1;
+
+	/* Gate is one for gates until the nodes are placed. */
+	for (r = 0; r <= regions; r++)
+		h->region_first[r] = 0;
+	for (n = 0; n < h->nodes; n++) {
+		h->gate[n] = 0;
+		for (i = h->edge_first[n]; i < h->edge_first[n + 1]; i++) {
+			if (h->node[h->edge[i].to].region != h->node[n].region)
+				h->gate[n] = 1;
+		}
+		h->region_first[h->node[n].region + 1]++;
+		h->gate_first[h->node[n].region + 1] += h->gate[n];
+	}
+	for (r = 0; r < regions; r++) {
+		h->region_first[r + 1] += h->region_first[r];
+		h->gate_first[r + 1] += h->gate_first[r];
+		h->hop_first[r] = h->region_first[r];
+	}
+	for (k = 1; k >= 0; k--) {
+		for (n = 0; n < h->nodes; n++) {
+			if (h->gate[n] == k)
+				h->region_node[h->hop_first[h->node[n].region]++] = n;
+		}
+	}
+
+	h->gates = h->gate_first[regions];
+	h->gate_node = (int*)malloc(sizeof(int) * (h->gates + 1));
+	h->gate_inner = (int*)malloc(sizeof(int) * (h->gates + 1));
+	if (h->gate_node == NULL || h->gate_inner == NULL)
+		return -1;
+
+	total = 0;
+	for (r = 0; r < regions; r++) {
+		base = h->region_first[r];
+		size = h->region_first[r + 1] - base;
+		if (size >= SDLMAN_HPA_NO_HOP)
+			return -1;
+		for (k = 0; k < size; k++) {
+			n = h->region_node[base + k];
+			h->slot[n] = k;
+			h->gate[n] = -1;
+			if (k < h->gate_first[r + 1] - h->gate_first[r]) {
+				h->gate[n] = h->gate_first[r] + k;
+				h->gate_node[h->gate[n]] = n;
+			}
+		}
+		h->hop_first[r] = total;
+		total += (h->gate_first[r + 1] - h->gate_first[r]) * size;
+	}
+	h->hop_first[regions] = total;
+
+	h->hop = (unsigned short*)malloc(sizeof(unsigned short) * (total + 1));
+	h->hop_cost = (unsigned short*)malloc(sizeof(unsigned short) * (total + 1));
+	if (h->hop == NULL || h->hop_cost == NULL)
+		return -1;
+
+	b->edges = 0;
+	for (r = 0; r < regions; r++) {
+		base = h->region_first[r];
+		size = h->region_first[r + 1] - base;
+		for (j = 0; j < h->gate_first[r + 1] - h->gate_first[r]; j++) {
+			g = h->region_node[base + j];
+			h->search++;
+			h->heap_size = 0;
+			h->stamp[g] = h->search;
+			h->cost[g] = 0;
+			h->parent[g] = -1;
+			sdlman_hpa_push(h, 0, 0, g);
+			best = SDLMAN_HPA_INFINITY;
+			sdlman_hpa_region_search(h, r, -1, &best);
+
+			/* The tree is walked from the other end, parents lead to the gate. */
+			table = h->hop_first[r] + (j * size);
+			for (k = 0; k < size; k++) {
+				n = h->region_node[base + k];
+				if (h->stamp[n] != h->search || h->cost[n] >= SDLMAN_HPA_NO_HOP) {
+					h->hop[table + k] = h->hop_cost[table + k] = SDLMAN_HPA_NO_HOP;
+					continue;
+				}
+				h->hop[table + k] = (h->parent[n] == -1) ? k : h->slot[h->parent[n]];
+				h->hop_cost[table + k] = h->cost[n];
+			}
+
+			/* Transitions first, the search only goes on inside at times. */
+			for (i = h->edge_first[g]; i < h->edge_first[g + 1]; i++) {
+				m = h->edge[i].to;
+				if (h->node[m].region != r &&
+					sdlman_hpa_add_edge(b, h->gate[g], h->gate[m], h->edge[i].cost) != 0)
+					return -1;
+			}
+			h->gate_inner[h->gate[g]] = b->edges;
+
+			for (k = 0; k < h->gate_first[r + 1] - h->gate_first[r]; k++) {
+				if (k != j && h->hop[table + k] != SDLMAN_HPA_NO_HOP &&
+					sdlman_hpa_add_edge(b, h->gate[g], h->gate_first[r] + k,
+					h->hop_cost[table + k]) != 0)
+					return -1;
+			}
+		}
+	}
+
+	/* Added gate by gate in order, so the inner starts stay in place. */
+	h->gate_edges = b->edges;
+	if (sdlman_hpa_group(b, h->gates, &h->gate_edge_first, &h->gate_edge) != 0)
+		return -1;
+	return 0;
+}
+
+
+
+/* Dijkstra between gates, from count gates numbered from first at once. */
+static void sdlman_hpa_spread(sdlman_hpa_t* h, int first, int count,
+	int* distance)
+{
+	int i, n, m, key, cost;
+
+	for (n = 0; n < h->gates; n++)
+		distance[n] = SDLMAN_HPA_INFINITY;
+
+	h->heap_size = 0;
+	for (n = first; n < first + count; n++) {
+		distance[n] = 0;
+		sdlman_hpa_push(h, 0, 0, n);
+	}
+
+	while (h->heap_size > 0) {
+		sdlman_hpa_pop(h, &key, &n);
+		if (key != distance[n])
+			continue; /* Stale. */
+		for (i = h->gate_edge_first[n]; i < h->gate_edge_first[n + 1]; i++) {
+			m = h->gate_edge[i].to;
+			cost = key + h->gate_edge[i].cost;
+			if (distance[m] <= cost)
+				continue;
+			distance[m] = cost;
+			sdlman_hpa_push(h, cost, 0, m);
+		}
+	}
+}
+
+
+
+/* Cost from every gate to the nearest gate of every region, which bounds
+ * the cost left when searching between gates. Too long saturates, which
+ * still leaves a bound. */
+static int sdlman_hpa_region_distances(sdlman_hpa_t* h)
+{
+	int r, g, regions;
+	int* distance;
+
+	regions = h->regions_x * h->regions_y;
+	h->region_distance = (unsigned short*)malloc(sizeof(unsigned short) *
+		((h->gates * regions) + 1));
+	if (h->region_distance == NULL)
+		return -1;
+
+	distance = h->finish_cost; /* Scratch. */
+	for (r = 0; r < regions; r++) {
+		sdlman_hpa_spread(h, h->gate_first[r],
+			h->gate_first[r + 1] - h->gate_first[r], distance);
+		for (g = 0; g < h->gates; g++) {
+			h->region_distance[(g * regions) + r] =
+				(distance[g] < SDLMAN_HPA_NO_HOP) ? distance[g] : SDLMAN_HPA_NO_HOP;
+		}
+	}
+
+	return 0;
+}
+
+
+
+/* Landmarks are gates far apart, each the farthest from those picked so
+ * far. Their distances to every gate give lower bounds for the search. */
+static int sdlman_hpa_landmarks(sdlman_hpa_t* h)
+{
+	int l, g, far;
+	int *nearest, *distance;
+
+	h->landmarks = 0;
+	h->landmark_distance = (int*)malloc(sizeof(int) *
+		((h->gates * SDLMAN_HPA_LANDMARKS) + 1));
+	if (h->landmark_distance == NULL)
+		return -1;
+	if (h->gates == 0)
+		return 0; /* Only one region. */
+
+	nearest = h->finish_cost; /* Scratch. */
+	distance = h->estimate;
+	sdlman_hpa_spread(h, 0, 1, nearest);
+
+	for (l = 0; l < SDLMAN_HPA_LANDMARKS; l++) {
+		far = -1;
+		for (g = 0; g < h->gates; g++) {
+			if (nearest[g] != SDLMAN_HPA_INFINITY &&
+				(far == -1 || nearest[g] > nearest[far]))
+				far = g;
+		}
+		if (far == -1 || nearest[far] == 0)
+			break;
+
+		sdlman_hpa_spread(h, far, 1, distance);
+		for (g = 0; g < h->gates; g++) {
+			h->landmark_distance[(g * SDLMAN_HPA_LANDMARKS) + l] = distance[g];
+			if (distance[g] < nearest[g])
+				nearest[g] = distance[g];
+		}
+		h->landmarks++;
+	}
+
+	return 0;
+}
+
+
+
+/* Forget all cached abstract paths. */
+static void sdlman_hpa_forget(sdlman_hpa_t* h)
+{
+	int i;
+
+	for (i = 0; i <= h->cache_mask; i++)
+		h->cache[i].from = -1;
+}
+
+
+
+static int sdlman_hpa_build(sdlman_hpa_t* h, sdlman_hpa_build_t* b)
+{
+	int i, j, a, n, c, x, y, d, edge_capacity, cluster_capacity, clusters;
+	int cache_size;
+	int left, right, top, bottom, length;
+
+	clusters = h->clusters_x * h->clusters_y;
+
+	/* Entrances on the vertical borders, including the wrapping one. */
+	for (x = 0; x < h->clusters_x; x++) {
+		left = ((x + 1) * h->cluster_size) - 1;
+		if (left > h->width - 1)
+			left = h->width - 1;
+		right = (left + 1) % h->width;
+		for (y = 0; y < h->height; y += h->cluster_size) {
+			length = h->cluster_size;
+			if (y + length > h->height)
+				length = h->height - y;
+			if (sdlman_hpa_add_entrances(h, b, (y * h->width) + left,
+				(y * h->width) + right, h->width, length) != 0)
+				return -1;
+		}
+	}
+
+	/* And on the horizontal borders. */
+	for (y = 0; y < h->clusters_y; y++) {
+		top = ((y + 1) * h->cluster_size) - 1;
+		if (top > h->height - 1)
+			top = h->height - 1;
+		bottom = (top + 1) % h->height;
+		for (x = 0; x < h->width; x += h->cluster_size) {
+			length = h->cluster_size;
+			if (x + length > h->width)
+				length = h->width - x;
+			if (sdlman_hpa_add_entrances(h, b, (top * h->width) + x,
+				(bottom * h->width) + x, 1, length) != 0)
+				return -1;
+		}
+	}
+
+	/* Group nodes by cluster. */
+	h->cluster_first = (int*)malloc(sizeof(int) * (clusters + 1));
+	h->cluster_node = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	if (h->cluster_first == NULL || h->cluster_node == NULL)
+		return -1;
+
+	/* Counting sort, the starts are shifted back into place afterwards. */
+	for (c = 0; c <= clusters; c++)
+		h->cluster_first[c] = 0;
+	for (n = 0; n < h->nodes; n++)
+		h->cluster_first[h->node[n].cluster + 1]++;
+	cluster_capacity = 0;
+	for (c = 0; c < clusters; c++) {
+		if (h->cluster_first[c + 1] > cluster_capacity)
+			cluster_capacity = h->cluster_first[c + 1];
+		h->cluster_first[c + 1] += h->cluster_first[c];
+	}
+	for (n = 0; n < h->nodes; n++)
+		h->cluster_node[h->cluster_first[h->node[n].cluster]++] = n;
+	for (c = clusters; c > 0; c--)
+		h->cluster_first[c] = h->cluster_first[c - 1];
+	h->cluster_first[0] = 0;
+
+	/* Precomputed distances between entrances of the same cluster. */
+	for (c = 0; c < clusters; c++) {
+		for (i = h->cluster_first[c]; i < h->cluster_first[c + 1]; i++) {
+			a = h->cluster_node[i];
+			sdlman_hpa_local_search(h, h->node[a].tile);
+			for (j = h->cluster_first[c]; j < h->cluster_first[c + 1]; j++) {
+				n = h->cluster_node[j];
+				if (n == a)
+					continue;
+				d = h->local_distance[sdlman_hpa_local(h, h->node[n].tile)];
+				if (d > 0 && sdlman_hpa_add_edge(b, a, n, d) != 0)
+					return -1;
+			}
+		}
+	}
+
+	/* Edges grouped by node. */
+	h->edges = b->edges;
+	if (sdlman_hpa_group(b, h->nodes, &h->edge_first, &h->edge) != 0)
+		return -1;
+
+	/* Query scratch. */
+	edge_capacity = h->edges + h->nodes + 1;
+	h->cost = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->parent = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->stamp = (int*)calloc(h->nodes + 1, sizeof(int));
+	h->goal_cost = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->goal_stamp = (int*)calloc(h->nodes + 1, sizeof(int));
+	h->heap_key = (int*)malloc(sizeof(int) * edge_capacity);
+	h->heap_tie = (int*)malloc(sizeof(int) * edge_capacity);
+	h->heap_node = (int*)malloc(sizeof(int) * edge_capacity);
+	h->start_node = (int*)malloc(sizeof(int) * (cluster_capacity + 1));
+	h->start_cost = (int*)malloc(sizeof(int) * (cluster_capacity + 1));
+	h->path = (int*)malloc(sizeof(int) * (h->nodes + 2));
+	h->estimate = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->region_bound = (int*)malloc(sizeof(int) *
+		((h->regions_x * h->regions_y) + 1));
+	h->start_via = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->finish_cost = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->finish_via = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->finish_stamp = (int*)calloc(h->nodes + 1, sizeof(int));
+	h->route = (int*)malloc(sizeof(int) * (h->nodes + 1));
+	h->route_cost = (int*)malloc(sizeof(int) * (h->nodes + 1));
+
+	/* Cache grows with the graph, since abstract paths get longer too. */
+	cache_size = SDLMAN_HPA_CACHE_MIN;
+	while (cache_size < h->nodes * SDLMAN_HPA_CACHE_PER_NODE &&
+		cache_size < SDLMAN_HPA_CACHE_MAX)
+		cache_size *= 2;
+	h->cache = (sdlman_hpa_cache_t*)malloc(sizeof(sdlman_hpa_cache_t) *
+		cache_size);
+	if (h->cost == NULL || h->parent == NULL || h->stamp == NULL ||
+		h->goal_cost == NULL || h->goal_stamp == NULL || h->heap_key == NULL ||
+		h->heap_tie == NULL || h->heap_node == NULL || h->start_node == NULL ||
+		h->start_cost == NULL || h->path == NULL || h->cache == NULL ||
+		h->estimate == NULL || h->region_bound == NULL || h->start_via == NULL ||
+		h->finish_cost == NULL || h->finish_via == NULL ||
+		h->finish_stamp == NULL || h->route == NULL || h->route_cost == NULL)
+		return -1;
+
+	h->cache_mask = cache_size - 1;
+	sdlman_hpa_forget(h);
+
+	if (sdlman_hpa_build_regions(h, b) != 0)
+		return -1;
+
+	/* The heap must also hold a search between gates. */
+	if (h->gate_edges > h->edges) {
+		edge_capacity = h->gate_edges + h->nodes + 1;
+		free(h->heap_key);
+		free(h->heap_tie);
+		free(h->heap_node);
+		h->heap_key = (int*)malloc(sizeof(int) * edge_capacity);
+		h->heap_tie = (int*)malloc(sizeof(int) * edge_capacity);
+		h->heap_node = (int*)malloc(sizeof(int) * edge_capacity);
+		if (h->heap_key == NULL || h->heap_tie == NULL || h->heap_node == NULL)
+			return -1;
+	}
+
+	if (sdlman_hpa_region_distances(h) != 0)
+		return -1;
+	return sdlman_hpa_landmarks(h);
+}
+
+
+
+/* Build cluster abstraction for world, NULL on failure. */
+sdlman_hpa_t* sdlman_hpa_create(char* world, int width, int height,
+	int cluster_size)
+{
+	int i, result;
+	sdlman_hpa_t* h;
+	sdlman_hpa_build_t b;
+
+	if (width < 2 || height < 2 || cluster_size < 2 || cluster_size > 255)
+		return NULL;
+
+	h = (sdlman_hpa_t*)calloc(1, sizeof(sdlman_hpa_t));
+	if (h == NULL) {
+		fprintf(stderr, "Error: Unable to allocate path finder.\n");
+		return NULL;
+	}
+
+	h->world = world;
+	h->width = width;
+	h->height = height;
+	h->cluster_size = cluster_size;
+	h->clusters_x = (width + cluster_size - 1) / cluster_size;
+	h->clusters_y = (height + cluster_size - 1) / cluster_size;
+
+	/* Small enough regions for their costs to fit the hop tables. */
+	h->region_size = cluster_size * SDLMAN_HPA_REGION;
+	while (h->region_size > cluster_size &&
+		h->region_size * h->region_size >= SDLMAN_HPA_NO_HOP)
+		h->region_size -= cluster_size;
+	h->regions_x = (width + h->region_size - 1) / h->region_size;
+	h->regions_y = (height + h->region_size - 1) / h->region_size;
+
+	b.node_alloc = b.edge_alloc = 256;
+	b.edges = 0;
+	b.from = (int*)malloc(sizeof(int) * b.edge_alloc);
+	b.edge = (sdlman_hpa_edge_t*)malloc(sizeof(sdlman_hpa_edge_t) * b.edge_alloc);
+	h->node = (sdlman_hpa_node_t*)malloc(sizeof(sdlman_hpa_node_t) * b.node_alloc);
+	h->node_of_tile = (int*)malloc(sizeof(int) * width * height);
+	h->local_distance = (int*)malloc(sizeof(int) * cluster_size * cluster_size);
+	h->local_queue = (int*)malloc(sizeof(int) * cluster_size * cluster_size);
+
+	if (b.from == NULL || b.edge == NULL || h->node == NULL ||
+		h->node_of_tile == NULL || h->local_distance == NULL ||
+		h->local_queue == NULL) {
+		result = -1;
+	}
+	else {
+		for (i = 0; i < width * height; i++)
+			h->node_of_tile[i] = -1;
+		result = sdlman_hpa_build(h, &b);
+	}
+
+	free(b.from);
+	free(b.edge);
+
+	if (result != 0) {
+		fprintf(stderr, "Error: Unable to allocate path finder graph.\n");
+		sdlman_hpa_destroy(h);
+		return NULL;
+	}
+
+	return h;
+}
+
+
+
+void sdlman_hpa_destroy(sdlman_hpa_t* h)
+{
+	if (h == NULL)
+		return;
+
+	free(h->node_of_tile);
+	free(h->node);
+	free(h->cluster_first);
+	free(h->cluster_node);
+	free(h->edge_first);
+	free(h->edge);
+	free(h->region_first);
+	free(h->region_node);
+	free(h->gate_first);
+	free(h->gate_node);
+	free(h->gate_inner);
+	free(h->slot);
+	free(h->hop_first);
+	free(h->hop);
+	free(h->hop_cost);
+	free(h->gate_edge_first);
+	free(h->gate_edge);
+	free(h->gate);
+	free(h->region_distance);
+	free(h->landmark_distance);
+	free(h->cache);
+	free(h->cost);
+	free(h->parent);
+	free(h->stamp);
+	free(h->goal_cost);
+	free(h->goal_stamp);
+	free(h->heap_key);
+	free(h->heap_tie);
+	free(h->heap_node);
+	free(h->start_node);
+	free(h->start_cost);
+	free(h->path);
+	free(h->estimate);
+	free(h->region_bound);
+	free(h->start_via);
+	free(h->finish_cost);
+	free(h->finish_via);
+	free(h->finish_stamp);
+	free(h->route);
+	free(h->route_cost);
+	free(h->local_distance);
+	free(h->local_queue);
+	free(h);
+}
+
+
+
+static sdlman_hpa_cache_t* sdlman_hpa_cache_entry(sdlman_hpa_t* h,
+	int from, int to)
+{
+	return &h->cache[(((unsigned int)from * 2654435761u) ^
+		((unsigned int)to * 40503u)) & h->cache_mask];
+}
+
+
+
+static void sdlman_hpa_append(sdlman_hpa_t* h, int tile)
+{
+	if (h->path_length > 0 && h->path[h->path_length - 1] == tile)
+		return;
+	h->path[h->path_length++] = tile;
+}
+
+
+
+/* Follow cached abstract path, keeping up to max waypoints. Returns 0 if
+ * some part was evicted, the whole path is checked so that a route followed
+ * step by step never flips between partly evicted paths. */
+static int sdlman_hpa_cache_path(sdlman_hpa_t* h, int from, int to, int max)
+{
+	int steps;
+	sdlman_hpa_cache_t* c;
+
+	sdlman_hpa_append(h, h->node[from].tile);
+	for (steps = 0; from != to && steps < h->nodes; steps++) {
+		c = sdlman_hpa_cache_entry(h, from, to);
+		if (c->from != from || c->to != to || c->next == -1)
+			return 0;
+		from = c->next;
+		if (h->path_length < max)
+			sdlman_hpa_append(h, h->node[from].tile);
+	}
+
+	return (from == to);
+}
+
+
+
+/* Cost from node to a gate of its region without leaving the region. */
+static int sdlman_hpa_gate_cost(sdlman_hpa_t* h, int gate, int node)
+{
+	int r, cost;
+
+	r = h->node[gate].region;
+	cost = h->hop_cost[h->hop_first[r] + (h->slot[gate] *
+		(h->region_first[r + 1] - h->region_first[r])) + h->slot[node]];
+
+	return (cost == SDLMAN_HPA_NO_HOP) ? SDLMAN_HPA_INFINITY : cost;
+}
+
+
+
+/* Add the steps from node to a gate of its region onto the route. */
+static void sdlman_hpa_hop(sdlman_hpa_t* h, int node, int gate)
+{
+	int r, base, table, next;
+
+	r = h->node[gate].region;
+	base = h->region_first[r];
+	table = h->hop_first[r] + (h->slot[gate] * (h->region_first[r + 1] - base));
+	while (node != gate) {
+		next = h->region_node[base + h->hop[table + h->slot[node]]];
+		h->route[h->route_length] = next;
+		h->route_cost[h->route_length++] = h->hop_cost[table + h->slot[node]] -
+			h->hop_cost[table + h->slot[next]];
+		node = next;
+	}
+}
+
+
+
+/* Lower bound on the cost left from a gate to the goal. The best of the
+ * distance on the map, the one through the nearest gate of the goal region,
+ * the one from the goal gates to the nearest gate of this region, and the
+ * landmarks on either side of the gate. */
+static int sdlman_hpa_estimate(sdlman_hpa_t* h, int gate, int to,
+	int region, int least)
+{
+	int l, x, best;
+	int* distance;
+	sdlman_hpa_node_t* node;
+
+	node = &h->node[h->gate_node[gate]];
+	best = sdlman_hpa_heuristic(h, node->tile, to);
+	x = h->region_distance[(gate * h->regions_x * h->regions_y) + region] + least;
+	if (x > best)
+		best = x;
+	if (h->region_bound[node->region] > best)
+		best = h->region_bound[node->region];
+
+	distance = &h->landmark_distance[gate * SDLMAN_HPA_LANDMARKS];
+	for (l = 0; l < h->landmarks; l++) {
+		x = distance[l];
+		if (x == SDLMAN_HPA_INFINITY)
+			continue;
+		if (h->landmark_far[l] - x > best)
+			best = h->landmark_far[l] - x;
+		if (x - h->landmark_near[l] > best)
+			best = x - h->landmark_near[l];
+	}
+
+	return best;
+}
+
+
+
+/* Route from tile to tile into path as waypoints, returns the count of them
+ * or -1 if not reachable. Waypoints are the start, the entrances passed on
+ * the way and the goal. Two waypoints following each other are either
+ * neighbours or inside the same cluster. A cached route only keeps the
+ * first max waypoints. */
+static int sdlman_hpa_route(sdlman_hpa_t* h, int from, int to, int max)
+{
+	int i, j, a, g, l, n, m, d, key, cost, starts, goals, best, best_start;
+	int best_goal, cs, cg, rs, rg, count, first, last, mark, least, regions;
+	sdlman_hpa_cache_t* c;
+
+	h->queries++;
+	h->path_length = 0;
+	if (h->world[from] == SDLMAN_WORLD_WALL || h->world[to] == SDLMAN_WORLD_WALL)
+		return -1;
+
+	sdlman_hpa_append(h, from);
+	if (from == to)
+		return 1;
+
+	cs = sdlman_hpa_cluster(h, from);
+	cg = sdlman_hpa_cluster(h, to);
+
+	/* Distances from the start to the entrances of its cluster. */
+	sdlman_hpa_local_search(h, from);
+	if (cs == cg && h->local_distance[sdlman_hpa_local(h, to)] != -1) {
+		/* Reachable without leaving the cluster. */
+		sdlman_hpa_append(h, to);
+		return h->path_length;
+	}
+
+	starts = 0;
+	for (i = h->cluster_first[cs]; i < h->cluster_first[cs + 1]; i++) {
+		a = h->cluster_node[i];
+		d = h->local_distance[sdlman_hpa_local(h, h->node[a].tile)];
+		if (d != -1) {
+			h->start_node[starts] = a;
+			h->start_cost[starts++] = d;
+		}
+	}
+
+	/* And from the goal, marked on the nodes for the searches. */
+	mark = ++h->search;
+	sdlman_hpa_local_search(h, to);
+	goals = 0;
+	for (i = h->cluster_first[cg]; i < h->cluster_first[cg + 1]; i++) {
+		a = h->cluster_node[i];
+		d = h->local_distance[sdlman_hpa_local(h, h->node[a].tile)];
+		if (d != -1) {
+			h->goal_stamp[a] = mark;
+			h->goal_cost[a] = d;
+			goals++;
+		}
+	}
+
+	if (starts == 0 || goals == 0) {
+		h->path_length = 0;
+		return -1;
+	}
+
+	/* Try the cache of abstract paths first. */
+	best = SDLMAN_HPA_INFINITY;
+	best_start = best_goal = -1;
+	for (i = 0; i < starts; i++) {
+		a = h->start_node[i];
+		for (j = h->cluster_first[cg]; j < h->cluster_first[cg + 1]; j++) {
+			n = h->cluster_node[j];
+			if (h->goal_stamp[n] != mark)
+				continue;
+			if (a == n) {
+				cost = 0;
+			}
+			else {
+				c = sdlman_hpa_cache_entry(h, a, n);
+				if (c->from != a || c->to != n)
+					continue;
+				cost = c->cost;
+			}
+			if (h->start_cost[i] + cost + h->goal_cost[n] < best) {
+				best = h->start_cost[i] + cost + h->goal_cost[n];
+				best_start = a;
+				best_goal = n;
+			}
+		}
+	}
+
+	if (best_start != -1) {
+		if (sdlman_hpa_cache_path(h, best_start, best_goal, max)) {
+			h->cache_hits++;
+			if (h->path_length < max)
+				sdlman_hpa_append(h, to);
+			return h->path_length;
+		}
+		h->path_length = 1; /* Evicted, search instead. */
+	}
+
+	/* Inside the region first, which also bounds the search between them. */
+	h->searches++;
+	rs = sdlman_hpa_region(h, from);
+	rg = sdlman_hpa_region(h, to);
+	best = SDLMAN_HPA_INFINITY;
+	h->route_length = 0;
+	if (rs == rg) {
+		h->search++;
+		h->heap_size = 0;
+		for (i = 0; i < starts; i++) {
+			a = h->start_node[i];
+			h->stamp[a] = h->search;
+			h->cost[a] = h->start_cost[i];
+			h->parent[a] = -1;
+			sdlman_hpa_push(h, h->cost[a], 0, a);
+		}
+
+		n = sdlman_hpa_region_search(h, rs, mark, &best);
+		if (n != -1) {
+			count = 0;
+			for (; n != -1; n = h->parent[n])
+				h->heap_node[count++] = n;
+			for (i = count - 1; i >= 0; i--) {
+				n = h->heap_node[i];
+				h->route[h->route_length] = n;
+				h->route_cost[h->route_length++] = (i < count - 1) ?
+					h->cost[n] - h->cost[h->heap_node[i + 1]] : 0;
+			}
+		}
+	}
+
+	/* Costs from the gates of the goal region to the goal, by gate number
+	 * like everything else in the search between gates. */
+	h->search++;
+	least = SDLMAN_HPA_INFINITY;
+	for (g = h->gate_first[rg]; g < h->gate_first[rg + 1]; g++) {
+		cost = SDLMAN_HPA_INFINITY;
+		for (i = h->cluster_first[cg]; i < h->cluster_first[cg + 1]; i++) {
+			a = h->cluster_node[i];
+			if (h->goal_stamp[a] != mark)
+				continue;
+			d = sdlman_hpa_gate_cost(h, h->gate_node[g], a) + h->goal_cost[a];
+			if (d < cost) {
+				cost = d;
+				h->finish_via[g] = a;
+			}
+		}
+		if (cost < SDLMAN_HPA_INFINITY) {
+			h->finish_stamp[g] = h->search;
+			h->finish_cost[g] = cost;
+			if (cost < least)
+				least = cost;
+		}
+	}
+
+	/* Bounds from all goal gates at once, for every region and landmark. */
+	regions = h->regions_x * h->regions_y;
+	for (a = 0; a < regions; a++)
+		h->region_bound[a] = SDLMAN_HPA_INFINITY;
+	for (l = 0; l < h->landmarks; l++) {
+		h->landmark_far[l] = SDLMAN_HPA_INFINITY;
+		h->landmark_near[l] = -SDLMAN_HPA_INFINITY;
+	}
+	for (g = h->gate_first[rg]; g < h->gate_first[rg + 1]; g++) {
+		if (h->finish_stamp[g] != h->search)
+			continue;
+		cost = h->finish_cost[g];
+		for (a = 0; a < regions; a++) {
+			d = h->region_distance[(g * regions) + a] + cost;
+			if (d < h->region_bound[a])
+				h->region_bound[a] = d;
+		}
+		for (l = 0; l < h->landmarks; l++) {
+			d = h->landmark_distance[(g * SDLMAN_HPA_LANDMARKS) + l];
+			if (d == SDLMAN_HPA_INFINITY)
+				continue;
+			if (d + cost < h->landmark_far[l])
+				h->landmark_far[l] = d + cost;
+			if (d - cost > h->landmark_near[l])
+				h->landmark_near[l] = d - cost;
+		}
+	}
+	for (l = 0; l < h->landmarks; l++) {
+		if (h->landmark_far[l] == SDLMAN_HPA_INFINITY) {
+			/* Landmark out of reach of the goal, no bound. */
+			h->landmark_far[l] = -SDLMAN_HPA_INFINITY;
+			h->landmark_near[l] = SDLMAN_HPA_INFINITY;
+		}
+	}
+
+	/* A* between gates, from all gates of the start region at once. Two
+	 * steps inside a region are never shorter than one, so gates reached
+	 * from inside their region only lead out of it. Estimates are a little
+	 * high, which keeps searches around detours short for routes at most
+	 * that much longer. */
+	h->heap_size = 0;
+	for (g = h->gate_first[rs]; least < SDLMAN_HPA_INFINITY &&
+		g < h->gate_first[rs + 1]; g++) {
+		cost = SDLMAN_HPA_INFINITY;
+		for (i = 0; i < starts; i++) {
+			d = h->start_cost[i] + sdlman_hpa_gate_cost(h, h->gate_node[g],
+				h->start_node[i]);
+			if (d < cost) {
+				cost = d;
+				h->start_via[g] = h->start_node[i];
+			}
+		}
+		if (cost >= SDLMAN_HPA_INFINITY)
+			continue;
+		h->stamp[g] = h->search;
+		h->cost[g] = cost;
+		h->parent[g] = -1;
+		h->estimate[g] = sdlman_hpa_estimate(h, g, to, rg, least);
+		h->estimate[g] += h->estimate[g] >> SDLMAN_HPA_GREED;
+		sdlman_hpa_push(h, cost + h->estimate[g], cost, g);
+	}
+
+	best_goal = -1;
+	while (h->heap_size > 0) {
+		sdlman_hpa_pop(h, &key, &n);
+		if (key >= best)
+			break;
+		if (key != h->cost[n] + h->estimate[n])
+			continue; /* Stale. */
+
+		if (h->finish_stamp[n] == h->search && h->cost[n] + h->finish_cost[n] < best) {
+			best = h->cost[n] + h->finish_cost[n];
+			best_goal = n;
+		}
+
+		/* Only gates entered from another region go on inside theirs. */
+		last = h->gate_inner[n];
+		if (h->parent[n] != -1 && h->node[h->gate_node[h->parent[n]]].region !=
+			h->node[h->gate_node[n]].region)
+			last = h->gate_edge_first[n + 1];
+		for (i = h->gate_edge_first[n]; i < last; i++) {
+			m = h->gate_edge[i].to;
+			cost = h->cost[n] + h->gate_edge[i].cost;
+			if (h->stamp[m] == h->search) {
+				if (h->cost[m] <= cost)
+					continue;
+			}
+			else {
+				h->estimate[m] = sdlman_hpa_estimate(h, m, to, rg, least);
+				h->estimate[m] += h->estimate[m] >> SDLMAN_HPA_GREED;
+			}
+			h->stamp[m] = h->search;
+			h->cost[m] = cost;
+			h->parent[m] = n;
+			sdlman_hpa_push(h, cost + h->estimate[m], cost, m);
+		}
+	}
+
+	/* Gates found, using the heap as scratch, and the entrances between. */
+	if (best_goal != -1) {
+		count = 0;
+		for (g = best_goal; g != -1; g = h->parent[g])
+			h->heap_node[count++] = g;
+
+		g = h->heap_node[count - 1];
+		n = h->gate_node[g];
+		h->route[0] = h->start_via[g];
+		h->route_cost[0] = 0;
+		h->route_length = 1;
+		sdlman_hpa_hop(h, h->start_via[g], n);
+		for (i = count - 2; i >= 0; i--) {
+			m = h->gate_node[h->heap_node[i]];
+			if (h->node[m].region != h->node[n].region) {
+				h->route[h->route_length] = m;
+				h->route_cost[h->route_length++] = h->cost[h->heap_node[i]] - h->cost[g];
+			}
+			else {
+				sdlman_hpa_hop(h, n, m);
+			}
+			g = h->heap_node[i];
+			n = m;
+		}
+
+		/* The last part is found from the goal end, so turn it around. */
+		first = h->route_length;
+		sdlman_hpa_hop(h, h->finish_via[g], n);
+		count = h->route_length - first;
+		for (i = 0; i < count; i++) {
+			h->heap_node[i] = h->route[first + i];
+			h->heap_key[i] = h->route_cost[first + i];
+		}
+		h->route_length = first;
+		for (i = count - 1; i >= 0; i--) {
+			h->route[h->route_length] = (i > 0) ? h->heap_node[i - 1] : h->finish_via[g];
+			h->route_cost[h->route_length++] = h->heap_key[i];
+		}
+	}
+
+	if (h->route_length == 0) {
+		h->path_length = 0;
+		return -1;
+	}
+
+	/* Cache every suffix, with costs left to the last entrance. */
+	cost = 0;
+	for (i = h->route_length - 1; i >= 0; i--) {
+		d = h->route_cost[i];
+		h->route_cost[i] = cost;
+		cost += d;
+	}
+
+	best_goal = h->route[h->route_length - 1];
+	for (i = 0; i < h->route_length; i++) {
+		n = h->route[i];
+		c = sdlman_hpa_cache_entry(h, n, best_goal);
+		c->from = n;
+		c->to = best_goal;
+		c->next = (i < h->route_length - 1) ? h->route[i + 1] : -1;
+		c->cost = h->route_cost[i];
+		sdlman_hpa_append(h, h->node[n].tile);
+	}
+
+	sdlman_hpa_append(h, to);
+	return h->path_length;
+}
+
+
+
+/* Copy up to max waypoints from tile to tile, returns the total count of
+ * waypoints or -1 if not reachable. */
+int sdlman_hpa_path(sdlman_hpa_t* h, int from, int to, int* waypoint, int max)
+{
+	int i, count;
+
+	count = sdlman_hpa_route(h, from, to, h->nodes + 2);
+	for (i = 0; i < count && i < max; i++)
+		waypoint[i] = h->path[i];
+
+	return count;
+}
+
+
+
+/* First direction to move in from tile to tile, or none. */
+int sdlman_hpa_direction(sdlman_hpa_t* h, int from, int to)
+{
+	int d, n, next, distance;
+
+	if (sdlman_hpa_route(h, from, to, 2) < 2)
+		return SDLMAN_DIRECTION_NONE;
+
+	next = h->path[1];
+	for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+		if (sdlman_wrap_neighbour(h->width, h->height, from, d) == next)
+			return d; /* Crossing into the next cluster. */
+	}
+
+	/* Next waypoint is inside the same cluster, go downhill towards it. */
+	sdlman_hpa_local_search(h, next);
+	distance = h->local_distance[sdlman_hpa_local(h, from)];
+	for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+		n = sdlman_wrap_neighbour(h->width, h->height, from, d);
+		if (h->world[n] == SDLMAN_WORLD_WALL ||
+			sdlman_hpa_cluster(h, n) != sdlman_hpa_cluster(h, from))
+			continue;
+		if (h->local_distance[sdlman_hpa_local(h, n)] == distance - 1)
+			return d;
+	}
+
+	return SDLMAN_DIRECTION_NONE;
+}
+
+
+
+/* Flat breadth first search, for measuring the quality of routes. */
+static int sdlman_hpa_flat_distance(sdlman_hpa_t* h, int from, int to,
+	int* distance, int* queue)
+{
+	int i, d, n, head, tail;
+
+	for (i = 0; i < h->width * h->height; i++)
+		distance[i] = -1;
+
+	head = tail = 0;
+	distance[from] = 0;
+	queue[tail++] = from;
+	while (head < tail) {
+		from = queue[head++];
+		if (from == to)
+			return distance[to];
+		for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+			n = sdlman_wrap_neighbour(h->width, h->height, from, d);
+			if (h->world[n] == SDLMAN_WORLD_WALL || distance[n] != -1)
+				continue;
+			distance[n] = distance[from] + 1;
+			queue[tail++] = n;
+		}
+	}
+
+	return -1;
+}
+
+
+
+/* Route between random tiles of a generated size by size maze, and report
+ * build time, query times and route length against flat search. Queries
+ * are timed over a few passes from an empty cache keeping the fastest, and
+ * the test fails if the slowest one is over the limit. */
+int sdlman_hpa_stress(int size)
+{
+	int i, k, pass, tile, steps, direction, walked, optimal_total;
+	int walked_total, result;
+	int from[SDLMAN_HPA_STRESS_QUERIES], to[SDLMAN_HPA_STRESS_QUERIES];
+	int optimal[SDLMAN_HPA_STRESS_WALKS];
+	int *distance, *queue;
+	char* world;
+	Uint64 start, elapsed, slowest, slowest_step, total;
+	Uint64 query_time[SDLMAN_HPA_STRESS_QUERIES];
+	Uint64* step_time;
+	sdlman_hpa_t* h;
+
+	if (size < 3) {
+		fprintf(stderr, "Error: Maze size must be at least 3.\n");
+		return -1;
+	}
+
+	world = (char*)malloc(size * size);
+	distance = (int*)malloc(sizeof(int) * size * size);
+	queue = (int*)malloc(sizeof(int) * size * size);
+	step_time = (Uint64*)malloc(sizeof(Uint64) * size * size);
+	if (world == NULL || distance == NULL || queue == NULL || step_time == NULL) {
+		fprintf(stderr, "Error: Unable to allocate %dx%d maze.\n", size, size);
+		free(world);
+		free(distance);
+		free(queue);
+		free(step_time);
+		return -1;
+	}
+
+	if (sdlman_maze_generate(world, size, size, (unsigned int)size,
+		SDLMAN_HPA_STRESS_LOOPS) != 0) {
+		free(world);
+		free(distance);
+		free(queue);
+		free(step_time);
+		return -1;
+	}
+
+	start = sdlman_timer_us();
+	h = sdlman_hpa_create(world, size, size, SDLMAN_HPA_STRESS_CLUSTER);
+	if (h == NULL) {
+		free(world);
+		free(distance);
+		free(queue);
+		free(step_time);
+		return -1;
+	}
+	elapsed = sdlman_timer_us() - start;
+	printf("Maze %dx%d: %d entrances, %d edges, built in %.1f ms.\n",
+		size, size, h->nodes, h->edges, (double)elapsed / 1000.0);
+	printf("Regions of %dx%d: %d gates, %d edges between them.\n",
+		h->region_size, h->region_size, h->gates, h->gate_edges);
+
+	for (i = 0; i < SDLMAN_HPA_STRESS_QUERIES; i++) {
+		do {
+			from[i] = rand() % (size * size);
+		} while (world[from[i]] == SDLMAN_WORLD_WALL);
+		do {
+			to[i] = rand() % (size * size);
+		} while (world[to[i]] == SDLMAN_WORLD_WALL);
+	}
+
+	/* Random routes, mostly needing a search of the abstract graph. */
+	for (pass = 0; pass < SDLMAN_HPA_STRESS_PASSES; pass++) {
+		sdlman_hpa_forget(h);
+		for (i = 0; i < SDLMAN_HPA_STRESS_QUERIES; i++) {
+			start = sdlman_timer_us();
+			sdlman_hpa_direction(h, from[i], to[i]);
+			elapsed = sdlman_timer_us() - start;
+			if (pass == 0 || elapsed < query_time[i])
+				query_time[i] = elapsed;
+		}
+	}
+	slowest = total = 0;
+	for (i = 0; i < SDLMAN_HPA_STRESS_QUERIES; i++) {
+		total += query_time[i];
+		if (query_time[i] > slowest)
+			slowest = query_time[i];
+	}
+	printf("Random routes: %.1f us average, %.1f us slowest per query.\n",
+		(double)total / SDLMAN_HPA_STRESS_QUERIES, (double)slowest);
+
+	/* Walk some routes step by step as an enemy would, mostly from the cache. */
+	for (i = 0; i < SDLMAN_HPA_STRESS_WALKS; i++)
+		optimal[i] = sdlman_hpa_flat_distance(h, from[i], to[i], distance, queue);
+
+	optimal_total = walked_total = k = 0;
+	for (pass = 0; pass < SDLMAN_HPA_STRESS_PASSES; pass++) {
+		sdlman_hpa_forget(h);
+		k = 0;
+		for (i = 0; i < SDLMAN_HPA_STRESS_WALKS; i++) {
+			if (optimal[i] <= 0)
+				continue;
+			tile = from[i];
+			for (walked = 0, steps = size * size; tile != to[i] && steps > 0; steps--) {
+				start = sdlman_timer_us();
+				direction = sdlman_hpa_direction(h, tile, to[i]);
+				elapsed = sdlman_timer_us() - start;
+				if (k < size * size) {
+					if (pass == 0 || elapsed < step_time[k])
+						step_time[k] = elapsed;
+					k++;
+				}
+				if (direction == SDLMAN_DIRECTION_NONE)
+					break;
+				tile = sdlman_wrap_neighbour(h->width, h->height, tile,
+					direction);
+				walked++;
+			}
+			if (pass > 0)
+				continue;
+			if (tile != to[i]) {
+				printf("Walk %d did not arrive.\n", i);
+				continue;
+			}
+			optimal_total += optimal[i];
+			walked_total += walked;
+		}
+	}
+	slowest_step = total = 0;
+	for (i = 0; i < k; i++) {
+		total += step_time[i];
+		if (step_time[i] > slowest_step)
+			slowest_step = step_time[i];
+	}
+	if (k > 0)
+		printf("Walked routes: %.1f us average, %.1f us slowest per step.\n",
+			(double)total / k, (double)slowest_step);
+	if (optimal_total > 0)
+		printf("Walked routes are %.1f%% longer than shortest.\n",
+			((double)walked_total / optimal_total - 1.0) * 100.0);
+	printf("%lu queries, %lu from cache, %lu searches.\n",
+		h->queries, h->cache_hits, h->searches);
+
+	result = 0;
+	if (slowest_step > slowest)
+		slowest = slowest_step;
+	if (slowest > SDLMAN_HPA_STRESS_LIMIT) {
+		fprintf(stderr, "Error: Slowest query took %.1f us, limit is %d us.\n",
+			(double)slowest, SDLMAN_HPA_STRESS_LIMIT);
+		result = -1;
+	}
+
+	sdlman_hpa_destroy(h);
+	free(world);
+	free(distance);
+	free(queue);
+	free(step_time);
+	return result;
+}
+
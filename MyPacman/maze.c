@@ -0,0 +1,119 @@
+/* SDL-Man (Maze Generator)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+/* Generate a width by height maze into world, using the same tile characters
+ * as the layout files. Cells at odd co-ordinates are carved with a depth first
+ * search, then loops percent of the remaining inner walls between two cells
+ * are knocked down so the maze has cycles like the built-in worlds. All open
+ * tiles get a pellet, and the player starts in the first cell. */
+int sdlman_maze_generate(char* world, int width, int height,
+	unsigned int seed, int loops)
+{
+	int i, x, y, n, d, cells_x, cells_y, top, cell, next, count;
+	int* stack;
+	int choice[4];
+
+	if (width < 3 || height < 3)
+		return -1;
+
+	cells_x = (width - 1) / 2;
+	cells_y = (height - 1) / 2;
+
+	stack = (int*)malloc(sizeof(int) * cells_x * cells_y);
+	if (stack == NULL) {
+		fprintf(stderr, "Error: Unable to allocate maze generator stack.\n");
+		return -1;
+	}
+
+	for (i = 0; i < width * height; i++)
+		world[i] = SDLMAN_WORLD_WALL;
+
+	/* Depth first carving, cell (x, y) is tile (x * 2 + 1, y * 2 + 1). */
+	top = 0;
+	stack[top++] = 0;
+	world[width + 1] = SDLMAN_WORLD_PELLET;
+	while (top > 0) {
+		cell = stack[top - 1];
+		x = cell % cells_x;
+		y = cell / cells_x;
+
+		count = 0;
+		for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+			switch (d) {
+			case SDLMAN_DIRECTION_UP:
+				next = (y > 0) ? cell - cells_x : -1;
+				break;
+			case SDLMAN_DIRECTION_DOWN:
+				next = (y < cells_y - 1) ? cell + cells_x : -1;
+				break;
+			case SDLMAN_DIRECTION_LEFT:
+				next = (x > 0) ? cell - 1 : -1;
+				break;
+			default:
+				next = (x < cells_x - 1) ? cell + 1 : -1;
+				break;
+			}
+			if (next == -1)
+				continue;
+			n = (((next / cells_x) * 2 + 1) * width) + ((next % cells_x) * 2 + 1);
+			if (world[n] == SDLMAN_WORLD_WALL)
+				choice[count++] = next;
+		}
+
+		if (count == 0) {
+			top--; /* Dead end, backtrack. */
+			continue;
+		}
+
+		next = choice[sdlman_random(&seed) % count];
+		n = (((next / cells_x) * 2 + 1) * width) + ((next % cells_x) * 2 + 1);
+		world[n] = SDLMAN_WORLD_PELLET;
+		/* Knock down the wall in between. */
+		world[(((y * 2 + 1) + ((next / cells_x) * 2 + 1)) / 2) * width +
+			(((x * 2 + 1) + ((next % cells_x) * 2 + 1)) / 2)] = SDLMAN_WORLD_PELLET;
+		stack[top++] = next;
+	}
+
+	/* Knock down some walls between two open tiles to make loops. */
+	for (y = 1; y < height - 1; y++) {
+		for (x = 1; x < width - 1; x++) {
+			n = (y * width) + x;
+			if (world[n] != SDLMAN_WORLD_WALL)
+				continue;
+			if (!((world[n - 1] != SDLMAN_WORLD_WALL && world[n + 1] != SDLMAN_WORLD_WALL) ||
+				(world[n - width] != SDLMAN_WORLD_WALL && world[n + width] != SDLMAN_WORLD_WALL)))
+				continue;
+			if ((int)(sdlman_random(&seed) % 100) < loops)
+				world[n] = SDLMAN_WORLD_PELLET;
+		}
+	}
+
+	world[width + 1] = SDLMAN_WORLD_PLAYER;
+
+	free(stack);
+	return 0;
+}
+
@@ -0,0 +1,427 @@
+/* SDL-Man (Tree Search)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <math.h> /* For sqrt() and log(). */
+#include <string.h> /* For memset(). */
+
+
+
+/* Local definitions. */
+#define SDLMAN_MCTS_BUDGET 8000 /* In microseconds per decision. */
+#define SDLMAN_MCTS_MOVE_TICKS 16 /* Longest move, in loop cycles. */
+#define SDLMAN_MCTS_TREE_DEPTH 12 /* In moves. */
+#define SDLMAN_MCTS_ROLLOUT_DEPTH 4 /* In moves. */
+#define SDLMAN_MCTS_DEATH -1000 /* Return for getting killed. */
+#define SDLMAN_MCTS_EXPLORE 30.0 /* In score points. */
+#define SDLMAN_MCTS_BENCH_TICKS 3000 /* In loop cycles. */
+
+
+
+/* Directions the player can take from here, returns how many. Turns are
+ * only possible inside a block, turning back always is. */
+static int sdlman_mcts_actions(sdlman_game_t* g, int* action)
+{
+	int d, n, tile, aligned, moving;
+
+	tile = sdlman_character_tile(&g->player);
+	aligned = sdlman_character_aligned(&g->player);
+	moving = g->player.moving_direction;
+
+	n = 0;
+	for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+		if (!aligned && moving != SDLMAN_DIRECTION_NONE && d != moving &&
+			d != sdlman_direction_opposite[moving])
+			continue;
+		if (g->world[sdlman_tile_neighbour(tile, d)] == SDLMAN_WORLD_WALL)
+			continue;
+		action[n++] = d;
+	}
+
+	if (n == 0 && moving != SDLMAN_DIRECTION_NONE)
+		action[n++] = moving; /* Between blocks, keep going. */
+
+	return n;
+}
+
+
+
+/* Hold direction until the player is inside the next block, returns the
+ * score gained on the way. */
+static int sdlman_mcts_move(sdlman_game_t* g, int direction)
+{
+	int i, tile, before;
+
+	tile = sdlman_character_tile(&g->player);
+	before = g->bonus + (g->consumed * SDLMAN_SCORE_PELLET);
+
+	sdlman_game_input(g, direction);
+	for (i = 0; i < SDLMAN_MCTS_MOVE_TICKS; i++) {
+		sdlman_game_step(g);
+		if (g->status != SDLMAN_GAME_RUNNING)
+			break;
+		if (sdlman_character_tile(&g->player) != tile &&
+			sdlman_character_aligned(&g->player))
+			break;
+	}
+
+	if (g->status == SDLMAN_GAME_KILLED)
+		return SDLMAN_MCTS_DEATH;
+	return g->bonus + (g->consumed * SDLMAN_SCORE_PELLET) - before;
+}
+
+
+
+/* Upper confidence bound pick among the expanded children. */
+static int sdlman_mcts_select(sdlman_mcts_worker_t* w, int n, int* action,
+	int actions)
+{
+	int i, child, best_action;
+	double score, best, parent_log;
+	sdlman_mcts_node_t* c;
+
+	parent_log = log((double)w->node[n].visits + 1.0);
+	best = 0.0;
+	best_action = action[0];
+	for (i = 0; i < actions; i++) {
+		child = w->node[n].child[action[i] - 1];
+		c = &w->node[child];
+		score = (c->value / c->visits) +
+			SDLMAN_MCTS_EXPLORE * sqrt(parent_log / c->visits);
+		if (i == 0 || score > best) {
+			best = score;
+			best_action = action[i];
+		}
+	}
+
+	return best_action;
+}
+
+
+
+/* One selection, expansion, rollout and update from the root. */
+static void sdlman_mcts_iterate(sdlman_mcts_worker_t* w, sdlman_game_t* root)
+{
+	int i, n, depth, total, actions, direction, unexpanded;
+	int path[SDLMAN_MCTS_TREE_DEPTH + 2];
+	int action[4];
+	sdlman_game_t* g;
+
+	g = &w->game;
+	sdlman_game_clone(g, root);
+	g->ai.reserve.search = &w->search; /* Not the one of the root. */
+
+	n = 0;
+	depth = 0;
+	total = 0;
+	path[depth] = n;
+
+	/* Walk down while every move from here has been tried. */
+	while (g->status == SDLMAN_GAME_RUNNING && depth < SDLMAN_MCTS_TREE_DEPTH) {
+		actions = sdlman_mcts_actions(g, action);
+		if (actions == 0)
+			break;
+
+		unexpanded = 0;
+		for (i = 0; i < actions; i++) {
+			if (w->node[n].child[action[i] - 1] == 0)
+				action[unexpanded++] = action[i];
+		}
+
+		if (unexpanded > 0) {
+			/* Expand one new move, if there is room for it. */
+			if (w->nodes >= SDLMAN_MCTS_NODES)
+				break;
+			direction = action[sdlman_random(&w->random) % unexpanded];
+			memset(&w->node[w->nodes], 0, sizeof(sdlman_mcts_node_t));
+			w->node[n].child[direction - 1] = w->nodes;
+			n = w->nodes++;
+			total += sdlman_mcts_move(g, direction);
+			path[++depth] = n;
+			break;
+		}
+
+		direction = sdlman_mcts_select(w, n, action, actions);
+		n = w->node[n].child[direction - 1];
+		total += sdlman_mcts_move(g, direction);
+		path[++depth] = n;
+	}
+
+	/* Random play from there, not turning back unless stuck. */
+	for (i = 0; i < SDLMAN_MCTS_ROLLOUT_DEPTH; i++) {
+		if (g->status != SDLMAN_GAME_RUNNING)
+			break;
+		actions = sdlman_mcts_actions(g, action);
+		if (actions == 0)
+			break;
+		direction = action[sdlman_random(&w->random) % actions];
+		if (actions > 1 && g->player.moving_direction != SDLMAN_DIRECTION_NONE &&
+			direction == sdlman_direction_opposite[g->player.moving_direction])
+			direction = action[sdlman_random(&w->random) % actions];
+		total += sdlman_mcts_move(g, direction);
+	}
+
+	for (i = 0; i <= depth; i++) {
+		w->node[path[i]].visits++;
+		w->node[path[i]].value += total;
+	}
+	w->iterations++;
+}
+
+
+
+static void sdlman_mcts_search(sdlman_mcts_worker_t* w)
+{
+	memset(&w->node[0], 0, sizeof(sdlman_mcts_node_t));
+	w->nodes = 1;
+	w->iterations = 0;
+
+	do {
+		sdlman_mcts_iterate(w, &w->mcts->root);
+	} while (sdlman_timer_us() < w->mcts->deadline);
+}
+
+
+
+static int sdlman_mcts_thread(void* data)
+{
+	sdlman_mcts_worker_t* w;
+
+	w = (sdlman_mcts_worker_t*)data;
+	while (1) {
+		SDL_SemWait(w->start);
+		if (w->mcts->quit)
+			break;
+		sdlman_mcts_search(w);
+		SDL_SemPost(w->done);
+	}
+
+	return 0;
+}
+
+
+
+/* Tree search with workers threads, 0 for one per processor. */
+sdlman_mcts_t* sdlman_mcts_create(int workers)
+{
+	int i;
+	sdlman_mcts_t* m;
+	sdlman_mcts_worker_t* w;
+
+	if (workers <= 0)
+		workers = sdlman_cpu_count();
+	if (workers > SDLMAN_MCTS_MAX_WORKERS)
+		workers = SDLMAN_MCTS_MAX_WORKERS;
+
+	m = (sdlman_mcts_t*)calloc(1, sizeof(sdlman_mcts_t));
+	if (m == NULL) {
+		fprintf(stderr, "Error: Unable to allocate tree search.\n");
+		return NULL;
+	}
+	m->budget_us = SDLMAN_MCTS_BUDGET;
+
+	for (i = 0; i < workers; i++) {
+		w = (sdlman_mcts_worker_t*)calloc(1, sizeof(sdlman_mcts_worker_t));
+		if (w == NULL) {
+			fprintf(stderr, "Error: Unable to allocate tree search worker.\n");
+			sdlman_mcts_destroy(m);
+			return NULL;
+		}
+		m->worker[i] = w;
+		m->workers = i + 1;
+		w->mcts = m;
+		w->random = (unsigned int)rand() + i;
+		sdlman_reserve_search_init(&w->search);
+		if (i == 0)
+			continue; /* Runs on the caller. */
+
+		w->start = SDL_CreateSemaphore(0);
+		w->done = SDL_CreateSemaphore(0);
+		if (w->start != NULL && w->done != NULL)
+			w->thread = SDL_CreateThread(sdlman_mcts_thread, w);
+		if (w->thread == NULL) {
+			fprintf(stderr, "Error: Unable to start tree search worker: %s\n",
+				SDL_GetError());
+			sdlman_mcts_destroy(m);
+			return NULL;
+		}
+	}
+
+	return m;
+}
+
+
+
+void sdlman_mcts_destroy(sdlman_mcts_t* m)
+{
+	int i;
+	sdlman_mcts_worker_t* w;
+
+	if (m == NULL)
+		return;
+
+	m->quit = 1;
+	for (i = 0; i < m->workers; i++) {
+		w = m->worker[i];
+		if (w->thread != NULL) {
+			SDL_SemPost(w->start);
+			SDL_WaitThread(w->thread, NULL);
+		}
+		if (w->start != NULL)
+			SDL_DestroySemaphore(w->start);
+		if (w->done != NULL)
+			SDL_DestroySemaphore(w->done);
+		free(w);
+	}
+	free(m);
+}
+
+
+
+/* Direction for the player, the move most searched by all workers. */
+int sdlman_mcts_direction(sdlman_mcts_t* m, sdlman_game_t* g)
+{
+	int i, d, actions, child, best, visits[4];
+	int action[4];
+
+	/* Moves are decided a block at a time. */
+	if (!sdlman_character_aligned(&g->player) &&
+		g->player.moving_direction != SDLMAN_DIRECTION_NONE)
+		return g->player.moving_direction;
+
+	actions = sdlman_mcts_actions(g, action);
+	if (actions == 0)
+		return SDLMAN_DIRECTION_NONE;
+	if (actions == 1)
+		return action[0]; /* Nothing to decide. */
+
+	/* Workers look at a copy, so the game is left alone. */
+	sdlman_game_clone(&m->root, g);
+	m->deadline = sdlman_timer_us() + m->budget_us;
+	for (i = 1; i < m->workers; i++)
+		SDL_SemPost(m->worker[i]->start);
+	sdlman_mcts_search(m->worker[0]);
+	for (i = 1; i < m->workers; i++)
+		SDL_SemWait(m->worker[i]->done);
+
+	for (d = 0; d < 4; d++)
+		visits[d] = 0;
+	for (i = 0; i < m->workers; i++) {
+		m->iterations += m->worker[i]->iterations;
+		for (d = 0; d < 4; d++) {
+			child = m->worker[i]->node[0].child[d];
+			if (child != 0)
+				visits[d] += m->worker[i]->node[child].visits;
+		}
+	}
+	m->decisions++;
+
+	best = action[0];
+	for (i = 1; i < actions; i++) {
+		if (visits[action[i] - 1] > visits[best - 1])
+			best = action[i];
+	}
+
+	return best;
+}
+
+
+
+/* Headless game of a world played by the tree search, reporting copy and
+ * step speed and search throughput. */
+int sdlman_mcts_bench(char* world_layout_file)
+{
+	int i, tick;
+	char world[SDLMAN_WORLD_TILES];
+	Uint64 start, elapsed;
+	sdlman_game_t* g, * copy;
+	sdlman_mcts_t* m;
+
+	if (sdlman_game_load_world(world_layout_file, world) != 0)
+		return -1;
+
+	g = (sdlman_game_t*)malloc(sizeof(sdlman_game_t));
+	copy = (sdlman_game_t*)malloc(sizeof(sdlman_game_t));
+	if (g == NULL || copy == NULL) {
+		fprintf(stderr, "Error: Unable to allocate game state.\n");
+		free(g);
+		free(copy);
+		return -1;
+	}
+
+	if (sdlman_game_init(g, world, 5, (unsigned int)rand()) != 0) {
+		free(g);
+		free(copy);
+		return -1;
+	}
+	g->ai.budget_us = 0; /* Same result every time. */
+	sdlman_game_step(g); /* Fills in the path table. */
+
+	/* Raw copy and step speed, playing at random. */
+	start = sdlman_timer_us();
+	for (i = 0; i < 100000; i++)
+		sdlman_game_clone(copy, g);
+	elapsed = sdlman_timer_us() - start;
+	printf("Game state of %u bytes, %.2f us per copy.\n",
+		(unsigned int)sizeof(sdlman_game_t), (double)elapsed / 100000);
+
+	start = sdlman_timer_us();
+	sdlman_game_clone(copy, g);
+	for (i = 0; i < 100000; i++) {
+		if (copy->status != SDLMAN_GAME_RUNNING)
+			sdlman_game_clone(copy, g);
+		if (sdlman_character_aligned(&copy->player))
+			sdlman_game_input(copy, (sdlman_game_random(copy) % 4) + 1);
+		sdlman_game_step(copy);
+	}
+	elapsed = sdlman_timer_us() - start;
+	printf("%.0f loop cycles per second.\n",
+		100000.0 * 1000000.0 / (double)(elapsed > 0 ? elapsed : 1));
+
+	m = sdlman_mcts_create(0);
+	if (m == NULL) {
+		sdlman_game_free(g);
+		free(g);
+		free(copy);
+		return -1;
+	}
+
+	for (tick = 0; tick < SDLMAN_MCTS_BENCH_TICKS; tick++) {
+		if (g->status != SDLMAN_GAME_RUNNING)
+			break;
+		g->player.moving_direction = sdlman_mcts_direction(m, g);
+		sdlman_game_step(g);
+	}
+
+	printf("%d workers, %.0f iterations per decision.\n", m->workers,
+		(m->decisions > 0) ? (double)m->iterations / m->decisions : 0.0);
+	printf("Played %d loop cycles, %d of %d pellets, score %d (%s).\n", tick,
+		g->consumed, g->total_pellets, sdlman_game_score(g),
+		(g->status == SDLMAN_GAME_KILLED) ? "killed" :
+		(g->status == SDLMAN_GAME_CLEARED) ? "cleared" : "time out");
+
+	sdlman_mcts_destroy(m);
+	sdlman_game_free(g);
+	free(g);
+	free(copy);
+	return 0;
+}
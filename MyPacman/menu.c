@@ -22,12 +22,10 @@
 #include "sdlman.h"
 #include <SDL_main.h> /* To remap main() for portability. */
 #include <time.h> /* To seed randomizer. */
+#include <string.h> /* For command line options. */
 
 
 
-#define SDLMAN_FILENAME_LENGTH 16
-#define SDLMAN_MAX_ENEMY_SPEED 9
-#define SDLMAN_MAX_WORLD 5
 #define SDLMAN_MENU_NUMBER_WIDTH 26
 #define SDLMAN_MENU_NUMBER_HEIGHT 32
 
@@ -149,18 +147,112 @@ static void sdlman_save_highscore(int* table, char* filename)
 
 
 
+/* Let the autopilot play every world, with the enemy speed going up by one
+ * for each round. Worlds that fail to load are skipped. */
+static int sdlman_autopilot(sdlman_display_t* display, int rounds, int pilot)
+{
+	int i, world_number, enemy_speed, game_result, game_score, played;
+	char layout_file[SDLMAN_FILENAME_LENGTH];
+	char graphic_file[SDLMAN_FILENAME_LENGTH];
+
+	played = 0;
+	for (i = 0; i < rounds; i++) {
+		enemy_speed = (i % SDLMAN_MAX_ENEMY_SPEED) + 1;
+		for (world_number = 1; world_number <= SDLMAN_MAX_WORLD; world_number++) {
+			snprintf(layout_file, SDLMAN_FILENAME_LENGTH, "world%d.layout",
+				world_number);
+			snprintf(graphic_file, SDLMAN_FILENAME_LENGTH, "world%d.bmp",
+				world_number);
+
+			game_result = sdlman_gameloop(display, layout_file, graphic_file,
+				enemy_speed, pilot, &game_score);
+			if (game_result == SDLMAN_GAMELOOP_QUIT)
+				return 0;
+			if (game_result != SDLMAN_GAMELOOP_OK) {
+				fprintf(stderr, "Warning: Skipping world %d.\n", world_number);
+				continue;
+			}
+
+			printf("Round %d, world %d, enemy speed %d: score %d.\n",
+				i + 1, world_number, enemy_speed, game_score);
+			played++;
+		}
+	}
+
+	if (played == 0) {
+		fprintf(stderr, "Error: No world could be played.\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
 int main(int argc, char* argv[])
 {
 	SDL_Event event;
 	SDL_Surface* screen, * menu_surface, * number_surface, * temp_surface;
+	sdlman_display_t display;
 	int game_done, game_result, world_number, enemy_speed, game_score;
+	int scale;
+	char* capture_file;
 	char layout_file[SDLMAN_FILENAME_LENGTH];
 	char graphic_file[SDLMAN_FILENAME_LENGTH];
 	int high_score[SDLMAN_MAX_WORLD];
+	int autopilot_rounds, autopilot;
 
 	/* Use srand() instead of srandom() to be more portable. */
 	srand((unsigned)time(NULL));
 
+	/* Window scale and capture, before any other option. */
+	scale = 1;
+	capture_file = NULL;
+	while (argc > 2) {
+		if (strcmp(argv[1], "-scale") == 0)
+			scale = atoi(argv[2]);
+		else if (strcmp(argv[1], "-capture") == 0)
+			capture_file = argv[2];
+		else
+			break;
+		argc -= 2;
+		argv += 2;
+	}
+
+	/* Batch tools, run instead of the menu. */
+	if (argc > 2 && strcmp(argv[1], "-hpa-stress") == 0)
+		return (sdlman_hpa_stress(atoi(argv[2])) == 0) ? 0 : 1;
+	if (argc > 2 && strcmp(argv[1], "-bitfill-bench") == 0)
+		return (sdlman_bitfill_bench(atoi(argv[2])) == 0) ? 0 : 1;
+	if (argc > 2 && strcmp(argv[1], "-mcts-bench") == 0)
+		return (sdlman_mcts_bench(argv[2]) == 0) ? 0 : 1;
+	if (argc > 2 && strcmp(argv[1], "-encode-bench") == 0)
+		return (sdlman_encode_bench(argv[2]) == 0) ? 0 : 1;
+	if (argc > 2 && strcmp(argv[1], "-pool-bench") == 0)
+		return (sdlman_pool_bench(atoi(argv[2])) == 0) ? 0 : 1;
+	if (argc > 3 && strcmp(argv[1], "-tournament") == 0)
+		return (sdlman_tournament(atoi(argv[2]), argv + 3, argc - 3) == 0) ?
+			0 : 1;
+	if (argc > 2 && strcmp(argv[1], "-difficulty") == 0)
+		return (sdlman_difficulty(atoi(argv[2]),
+			(argc > 3) ? argv[3] : NULL) == 0) ? 0 : 1;
+	if (argc > 2 && strcmp(argv[1], "-route") == 0)
+		return (sdlman_route_tool(argv[2], (argc > 3) ? argv[3] : NULL) == 0) ?
+			0 : 1;
+	if (argc > 1 && strcmp(argv[1], "-scale-bench") == 0)
+		return (sdlman_scale_bench() == 0) ? 0 : 1;
+	if (argc > 2 && strcmp(argv[1], "-raster-bench") == 0)
+		return (sdlman_raster_bench(argv[2], (argc > 3) ? argv[3] : NULL) == 0) ?
+			0 : 1;
+
+	autopilot_rounds = 0;
+	autopilot = SDLMAN_PILOT_GREEDY;
+	if (argc > 2 && strcmp(argv[1], "-autopilot") == 0) {
+		autopilot_rounds = atoi(argv[2]);
+		if (argc > 3 && strcmp(argv[3], "mcts") == 0)
+			autopilot = SDLMAN_PILOT_MCTS;
+	}
+
 	/* Try to load highscores from persistent file. */
 	sdlman_load_highscore(high_score, SDLMAN_HIGHSCORE_FILE);
 
@@ -170,20 +262,32 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 	atexit(SDL_Quit);
-	screen = SDL_SetVideoMode(SDLMAN_WORLD_X_SIZE * SDLMAN_BLOCK_SIZE,
-		SDLMAN_WORLD_Y_SIZE * SDLMAN_BLOCK_SIZE, 24, SDL_DOUBLEBUF);
-	if (screen == NULL) {
-		fprintf(stderr, "Error: Unable to set video mode: %s\n", SDL_GetError());
+	if (sdlman_display_open(&display, scale) != 0)
 		return 1;
+	screen = display.screen; /* Drawn into at the native size. */
+	if (capture_file != NULL) {
+		display.capture = sdlman_capture_open(capture_file, screen);
+		if (display.capture == NULL) {
+			sdlman_display_close(&display);
+			return 1;
+		}
 	}
 	SDL_WM_SetCaption("SDL-Man", "SDL-Man");
 
+	/* Unattended runs, instead of the menu. */
+	if (autopilot_rounds > 0) {
+		game_result = sdlman_autopilot(&display, autopilot_rounds, autopilot);
+		sdlman_display_close(&display);
+		return (game_result == 0) ? 0 : 1;
+	}
+
 
 	/* Load and convert menu graphic files. */
 	temp_surface = SDL_LoadBMP("menu.bmp");
 	if (temp_surface == NULL) {
 		fprintf(stderr, "Error: Unable to load menu graphics: %s\n",
 			SDL_GetError());
+		sdlman_display_close(&display);
 		return 1;
 	}
 	else {
@@ -191,6 +295,7 @@ int main(int argc, char* argv[])
 		if (menu_surface == NULL) {
 			fprintf(stderr, "Error: Unable to convert menu graphics: %s\n",
 				SDL_GetError());
+			sdlman_display_close(&display);
 			return 1;
 		}
 		SDL_FreeSurface(temp_surface);
@@ -201,6 +306,7 @@ int main(int argc, char* argv[])
 		fprintf(stderr, "Error: Unable to load number graphics: %s\n",
 			SDL_GetError());
 		SDL_FreeSurface(menu_surface);
+		sdlman_display_close(&display);
 		return 1;
 	}
 	else {
@@ -209,6 +315,7 @@ int main(int argc, char* argv[])
 			fprintf(stderr, "Error: Unable to convert enemy graphics: %s\n",
 				SDL_GetError());
 			SDL_FreeSurface(menu_surface);
+			sdlman_display_close(&display);
 			return 1;
 		}
 		SDL_FreeSurface(temp_surface);
@@ -244,8 +351,8 @@ int main(int argc, char* argv[])
 					snprintf(graphic_file, SDLMAN_FILENAME_LENGTH, "world%d.bmp",
 						world_number);
 
-					game_result = sdlman_gameloop(screen, layout_file, graphic_file,
-						enemy_speed, &game_score);
+					game_result = sdlman_gameloop(&display, layout_file, graphic_file,
+						enemy_speed, SDLMAN_PILOT_NONE, &game_score);
 
 					if (game_result == SDLMAN_GAMELOOP_OK) {
 						/* Update high score. */
@@ -287,7 +394,7 @@ int main(int argc, char* argv[])
 		sdlman_draw_menu_number(screen, number_surface, 385, 259,
 			high_score[world_number - 1]);
 
-		SDL_Flip(screen);
+		sdlman_display_flip(&display);
 		SDL_Delay(SDLMAN_GAME_SPEED);
 	}
 
@@ -295,7 +402,7 @@ int main(int argc, char* argv[])
 	/* Cleanup. */
 	SDL_FreeSurface(menu_surface);
 	SDL_FreeSurface(number_surface);
-	SDL_FreeSurface(screen);
+	sdlman_display_close(&display);
 	sdlman_save_highscore(high_score, SDLMAN_HIGHSCORE_FILE);
 
 	return 0;
@@ -0,0 +1,98 @@
+/* SDL-Man (Parallel Jobs)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+static int sdlman_parallel_thread(void* data)
+{
+	int n;
+	sdlman_parallel_worker_t* w;
+	sdlman_parallel_t* p;
+
+	w = (sdlman_parallel_worker_t*)data;
+	p = w->parallel;
+	while (1) {
+		SDL_mutexP(p->lock);
+		n = p->next++;
+		SDL_mutexV(p->lock);
+		if (n >= p->jobs)
+			break;
+		p->job(p->data, n, w->index);
+	}
+
+	return 0;
+}
+
+
+
+/* Run jobs 0 to jobs - 1 on up to workers threads, 0 for one per
+ * processor, and wait for all of them. A job is given its number and the
+ * number of the worker running it, below the workers count, so workers can
+ * keep state of their own. Returns the number of workers used. */
+int sdlman_parallel_run(int workers, int jobs, sdlman_job_t job, void* data)
+{
+	int i, started;
+	sdlman_parallel_t p;
+	sdlman_parallel_worker_t worker[SDLMAN_PARALLEL_MAX_WORKERS];
+
+	if (workers <= 0)
+		workers = sdlman_cpu_count();
+	if (workers > SDLMAN_PARALLEL_MAX_WORKERS)
+		workers = SDLMAN_PARALLEL_MAX_WORKERS;
+
+	p.lock = SDL_CreateMutex();
+	if (p.lock == NULL) {
+		fprintf(stderr, "Error: Unable to create job lock: %s\n",
+			SDL_GetError());
+		return -1;
+	}
+	p.next = 0;
+	p.jobs = jobs;
+	p.job = job;
+	p.data = data;
+
+	/* The caller is worker 0, and carries on alone if threads run out. */
+	started = 1;
+	for (i = 1; i < workers; i++) {
+		worker[i].parallel = &p;
+		worker[i].index = i;
+		worker[i].thread = SDL_CreateThread(sdlman_parallel_thread, &worker[i]);
+		if (worker[i].thread == NULL) {
+			fprintf(stderr, "Warning: Unable to start worker thread: %s\n",
+				SDL_GetError());
+			break;
+		}
+		started++;
+	}
+	worker[0].parallel = &p;
+	worker[0].index = 0;
+	worker[0].thread = NULL;
+	sdlman_parallel_thread(&worker[0]);
+
+	for (i = 1; i < started; i++)
+		SDL_WaitThread(worker[i].thread, NULL);
+	SDL_DestroyMutex(p.lock);
+
+	return started;
+}
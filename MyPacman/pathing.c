@@ -0,0 +1,405 @@
+/* SDL-Man (Pathing)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sdlman.h"
+
+
+
+/* Local definitions. */
+#define SDLMAN_FLEE_SCALE 6 /* Inverted distance is scaled by 6/5... */
+#define SDLMAN_FLEE_STEP 5 /* ...against a step cost of 5. */
+
+
+
+const int sdlman_direction_opposite[5] = {
+	SDLMAN_DIRECTION_NONE,
+	SDLMAN_DIRECTION_DOWN,
+	SDLMAN_DIRECTION_UP,
+	SDLMAN_DIRECTION_RIGHT,
+	SDLMAN_DIRECTION_LEFT,
+};
+
+
+
+/* Tile of the character center, wrapped like sdlman_world_collision. */
+int sdlman_character_tile(sdlman_character_t* c)
+{
+	int x, y;
+
+	x = c->x + (SDLMAN_CHARACTER_SIZE / 2) +
+		(SDLMAN_WORLD_X_SIZE * SDLMAN_BLOCK_SIZE);
+	y = c->y + (SDLMAN_CHARACTER_SIZE / 2) +
+		(SDLMAN_WORLD_Y_SIZE * SDLMAN_BLOCK_SIZE);
+	x = (x / SDLMAN_BLOCK_SIZE) % SDLMAN_WORLD_X_SIZE;
+	y = (y / SDLMAN_BLOCK_SIZE) % SDLMAN_WORLD_Y_SIZE;
+
+	return (y * SDLMAN_WORLD_X_SIZE) + x;
+}
+
+
+
+/* Check if character is standing inside a single block in both directions. */
+int sdlman_character_aligned(sdlman_character_t* c)
+{
+	if (c->x < 0 || c->y < 0)
+		return 0; /* Wrapping around the edge. */
+
+	if (c->x / SDLMAN_BLOCK_SIZE !=
+		(c->x + SDLMAN_CHARACTER_SIZE - 1) / SDLMAN_BLOCK_SIZE)
+		return 0;
+
+	if (c->y / SDLMAN_BLOCK_SIZE !=
+		(c->y + SDLMAN_CHARACTER_SIZE - 1) / SDLMAN_BLOCK_SIZE)
+		return 0;
+
+	return 1;
+}
+
+
+
+/* Neighbour in a width by height world wrapping around the edges, the
+ * tile itself for no direction. */
+int sdlman_wrap_neighbour(int width, int height, int tile, int direction)
+{
+	int x, y;
+
+	x = tile % width;
+	y = tile / width;
+
+	switch (direction) {
+	case SDLMAN_DIRECTION_UP:
+		y = (y + height - 1) % height;
+		break;
+
+	case SDLMAN_DIRECTION_DOWN:
+		y = (y + 1) % height;
+		break;
+
+	case SDLMAN_DIRECTION_LEFT:
+		x = (x + width - 1) % width;
+		break;
+
+	case SDLMAN_DIRECTION_RIGHT:
+		x = (x + 1) % width;
+		break;
+
+	default:
+		break;
+	}
+
+	return (y * width) + x;
+}
+
+
+
+int sdlman_tile_neighbour(int tile, int direction)
+{
+	return sdlman_wrap_neighbour(SDLMAN_WORLD_X_SIZE, SDLMAN_WORLD_Y_SIZE,
+		tile, direction);
+}
+
+
+
+/* Breadth first search from tile, returns number of tiles reached.
+ * The visiting order (increasing distance) is stored in order if not NULL. */
+int sdlman_distance_map(char* world, int tile, int* distance, int* order)
+{
+	int i, d, n, head, tail;
+	int queue[SDLMAN_WORLD_TILES];
+
+	if (order == NULL)
+		order = queue;
+
+	for (i = 0; i < SDLMAN_WORLD_TILES; i++)
+		distance[i] = -1;
+
+	head = tail = 0;
+	distance[tile] = 0;
+	order[tail++] = tile;
+
+	while (head < tail) {
+		tile = order[head++];
+		for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+			n = sdlman_tile_neighbour(tile, d);
+			if (world[n] == SDLMAN_WORLD_WALL || distance[n] != -1)
+				continue;
+			distance[n] = distance[tile] + 1;
+			order[tail++] = n;
+		}
+	}
+
+	return tail;
+}
+
+
+
+void sdlman_flee_field_init(sdlman_flee_field_t* f)
+{
+	int i;
+
+	f->player_tile = -1;
+	f->stage = SDLMAN_FLEE_DONE;
+	for (i = 0; i < SDLMAN_WORLD_TILES; i++) {
+		f->distance[i] = -1;
+		f->direction[i] = SDLMAN_DIRECTION_NONE;
+	}
+}
+
+
+
+/* Start computing the field for player tile, finished by stepping it. */
+void sdlman_flee_field_begin(sdlman_flee_field_t* f, int player_tile)
+{
+	int i;
+
+	f->player_tile = -1; /* Not valid until done. */
+	for (i = 0; i < SDLMAN_WORLD_TILES; i++) {
+		f->distance[i] = -1;
+		f->direction[i] = SDLMAN_DIRECTION_NONE;
+	}
+
+	f->target = player_tile;
+	f->distance[player_tile] = 0;
+	f->order[0] = player_tile;
+	f->head = 0;
+	f->tail = 1;
+	f->stage = SDLMAN_FLEE_SEARCH;
+}
+
+
+
+/* Process up to units tiles of work, returns 1 when the field is done. */
+int sdlman_flee_field_step(sdlman_flee_field_t* f, char* world, int units)
+{
+	int i, d, n, t, best;
+
+	while (units-- > 0) {
+		switch (f->stage) {
+		case SDLMAN_FLEE_SEARCH:
+			/* Player distance map, breadth first. */
+			if (f->head == f->tail) {
+				/* Scaled, inverted distance. Going away from the player is downhill. */
+				for (i = 0; i < SDLMAN_WORLD_TILES; i++)
+					f->value[i] = -f->distance[i] * SDLMAN_FLEE_SCALE;
+				f->seed = f->tail - 1;
+				f->queue_head = f->queue_tail = 0;
+				f->stage = SDLMAN_FLEE_RELAX;
+				break;
+			}
+			t = f->order[f->head++];
+			for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+				n = sdlman_tile_neighbour(t, d);
+				if (world[n] == SDLMAN_WORLD_WALL || f->distance[n] != -1)
+					continue;
+				f->distance[n] = f->distance[t] + 1;
+				f->order[f->tail++] = n;
+			}
+			break;
+
+		case SDLMAN_FLEE_RELAX:
+			/* Relax with one extra breadth first pass, so dead ends far away from
+			 * the player are no longer attractive when the way out passes near the
+			 * player. Seeds are the BFS order reversed (increasing value), merged
+			 * with a FIFO of relaxed tiles which is also increasing since step
+			 * cost is uniform. */
+			if (f->seed < 0 && f->queue_head == f->queue_tail) {
+				f->index = 0;
+				f->stage = SDLMAN_FLEE_POINT;
+				break;
+			}
+			if (f->queue_head < f->queue_tail && (f->seed < 0 ||
+				f->value[f->queue[f->queue_head]] <=
+				-f->distance[f->order[f->seed]] * SDLMAN_FLEE_SCALE)) {
+				t = f->queue[f->queue_head++];
+			}
+			else {
+				t = f->order[f->seed--];
+				if (f->value[t] != -f->distance[t] * SDLMAN_FLEE_SCALE)
+					break; /* Already relaxed through the queue. */
+			}
+			for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+				n = sdlman_tile_neighbour(t, d);
+				if (f->distance[n] == -1)
+					continue; /* Wall or unreachable. */
+				if (f->value[t] + SDLMAN_FLEE_STEP < f->value[n]) {
+					f->value[n] = f->value[t] + SDLMAN_FLEE_STEP;
+					f->queue[f->queue_tail++] = n;
+				}
+			}
+			break;
+
+		case SDLMAN_FLEE_POINT:
+			/* Point every reachable tile downhill, local minimums stay at none. */
+			if (f->index == f->tail) {
+				f->player_tile = f->target;
+				f->stage = SDLMAN_FLEE_DONE;
+				return 1;
+			}
+			t = f->order[f->index++];
+			best = f->value[t];
+			for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+				n = sdlman_tile_neighbour(t, d);
+				if (f->distance[n] == -1)
+					continue;
+				if (f->value[n] < best) {
+					best = f->value[n];
+					f->direction[t] = d;
+				}
+			}
+			break;
+
+		default:
+			return 1;
+		}
+	}
+
+	return (f->stage == SDLMAN_FLEE_DONE);
+}
+
+
+
+void sdlman_flee_field_update(sdlman_flee_field_t* f, char* world,
+	int player_tile)
+{
+	if (f->player_tile == player_tile)
+		return; /* Still valid. */
+
+	sdlman_flee_field_begin(f, player_tile);
+	while (sdlman_flee_field_step(f, world, SDLMAN_WORLD_TILES) == 0)
+		;
+}
+
+
+
+int sdlman_flee_field_direction(sdlman_flee_field_t* f, int tile)
+{
+	return f->direction[tile];
+}
+
+
+
+/* All pairs shortest paths for the world, filled in by stepping it. */
+sdlman_path_table_t* sdlman_path_table_create(char* world)
+{
+	int i, n, from, to, best, score;
+	sdlman_path_table_t* t;
+
+	t = (sdlman_path_table_t*)malloc(sizeof(sdlman_path_table_t));
+	if (t == NULL)
+		return NULL;
+
+	t->fill = sdlman_bitfill_create(world, SDLMAN_WORLD_X_SIZE,
+		SDLMAN_WORLD_Y_SIZE);
+	if (t->fill == NULL) {
+		free(t);
+		return NULL;
+	}
+
+	t->rows = 0;
+	for (to = 0; to < SDLMAN_WORLD_TILES; to++) {
+		for (from = 0; from < SDLMAN_WORLD_TILES; from++) {
+			t->distance[to][from] = -1;
+			t->next[to][from] = SDLMAN_DIRECTION_NONE;
+		}
+	}
+
+	/* Open tiles closest to each corner of the world. */
+	for (i = 0; i < 4; i++) {
+		best = -1;
+		t->corner[i] = 0;
+		for (n = 0; n < SDLMAN_WORLD_TILES; n++) {
+			if (world[n] == SDLMAN_WORLD_WALL)
+				continue;
+			if (i % 2 == 0)
+				score = n % SDLMAN_WORLD_X_SIZE;
+			else
+				score = SDLMAN_WORLD_X_SIZE - 1 - (n % SDLMAN_WORLD_X_SIZE);
+			if (i < 2)
+				score += n / SDLMAN_WORLD_X_SIZE;
+			else
+				score += SDLMAN_WORLD_Y_SIZE - 1 - (n / SDLMAN_WORLD_X_SIZE);
+			if (best == -1 || score < best) {
+				best = score;
+				t->corner[i] = n;
+			}
+		}
+	}
+
+	return t;
+}
+
+
+
+/* Compute up to rows more targets, returns 1 when the table is complete. */
+int sdlman_path_table_step(sdlman_path_table_t* t, char* world, int rows)
+{
+	int d, n, from, to;
+	int distance[SDLMAN_WORLD_TILES];
+
+	/* The graph is undirected, so a BFS from the target gives the distance
+	 * from every tile to it, and the next step is any tile one closer. */
+	while (rows-- > 0 && t->rows < SDLMAN_WORLD_TILES) {
+		to = t->rows++;
+		if (world[to] == SDLMAN_WORLD_WALL)
+			continue;
+		sdlman_bitfill_distance(t->fill, &to, 1, distance);
+		for (from = 0; from < SDLMAN_WORLD_TILES; from++) {
+			t->distance[to][from] = (short)distance[from];
+			if (distance[from] <= 0)
+				continue;
+			for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+				n = sdlman_tile_neighbour(from, d);
+				if (distance[n] == distance[from] - 1 && world[n] != SDLMAN_WORLD_WALL) {
+					t->next[to][from] = d;
+					break;
+				}
+			}
+		}
+	}
+
+	return (t->rows == SDLMAN_WORLD_TILES);
+}
+
+
+
+void sdlman_path_table_destroy(sdlman_path_table_t* t)
+{
+	if (t == NULL)
+		return;
+
+	sdlman_bitfill_destroy(t->fill);
+	free(t);
+}
+
+
+
+int sdlman_path_distance(sdlman_path_table_t* t, int from, int to)
+{
+	return t->distance[to][from];
+}
+
+
+
+int sdlman_path_direction(sdlman_path_table_t* t, int from, int to)
+{
+	return t->next[to][from];
+}
+
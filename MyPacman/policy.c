@@ -0,0 +1,166 @@
+/* SDL-Man (Player Policies)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For strcmp(). */
+
+
+
+/* Policy by name, "random", "greedy" or the file name of a shared library
+ * exporting SDLMAN_POLICY_SYMBOL. */
+int sdlman_policy_load(sdlman_policy_t* p, char* name)
+{
+	snprintf(p->name, SDLMAN_POLICY_NAME_LENGTH, "%s", name);
+	p->object = NULL;
+	p->step = NULL;
+
+	if (strcmp(name, "random") == 0) {
+		p->type = SDLMAN_POLICY_RANDOM;
+		return 0;
+	}
+	if (strcmp(name, "greedy") == 0) {
+		p->type = SDLMAN_POLICY_GREEDY;
+		return 0;
+	}
+
+	p->type = SDLMAN_POLICY_LIBRARY;
+	p->object = SDL_LoadObject(name);
+	if (p->object == NULL) {
+		fprintf(stderr, "Error: Unable to load policy '%s': %s\n", name,
+			SDL_GetError());
+		return -1;
+	}
+	p->step = (sdlman_policy_step_t)SDL_LoadFunction(p->object,
+		SDLMAN_POLICY_SYMBOL);
+	if (p->step == NULL) {
+		fprintf(stderr, "Error: No %s in policy '%s'.\n", SDLMAN_POLICY_SYMBOL,
+			name);
+		SDL_UnloadObject(p->object);
+		p->object = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
+void sdlman_policy_unload(sdlman_policy_t* p)
+{
+	if (p->object != NULL)
+		SDL_UnloadObject(p->object);
+	p->object = NULL;
+	p->step = NULL;
+}
+
+
+
+sdlman_player_t* sdlman_player_create(void)
+{
+	sdlman_player_t* pl;
+
+	pl = (sdlman_player_t*)malloc(sizeof(sdlman_player_t));
+	if (pl == NULL) {
+		fprintf(stderr, "Error: Unable to allocate player.\n");
+		return NULL;
+	}
+
+	pl->heatmap = NULL;
+	pl->env = sdlman_env_create(NULL);
+	if (pl->env == NULL) {
+		free(pl);
+		return NULL;
+	}
+
+	return pl;
+}
+
+
+
+void sdlman_player_destroy(sdlman_player_t* pl)
+{
+	if (pl == NULL)
+		return;
+	sdlman_env_destroy(pl->env);
+	free(pl);
+}
+
+
+
+static int sdlman_player_random(sdlman_player_t* pl, sdlman_game_t* g)
+{
+	if (!sdlman_character_aligned(&g->player) &&
+		g->player.moving_direction != SDLMAN_DIRECTION_NONE)
+		return g->player.moving_direction;
+
+	return (sdlman_random(&pl->random) % 4) + 1;
+}
+
+
+
+/* Play a game of a cached level to the end, or to max_ticks. Returns how
+ * it ended, the score and everything else is left in the game of the
+ * player's environment. */
+int sdlman_player_play(sdlman_player_t* pl, sdlman_policy_t* p,
+	sdlman_level_t* level, int enemy_speed, unsigned int seed, int max_ticks)
+{
+	int action;
+	sdlman_game_t* g;
+
+	if (sdlman_env_start(pl->env, level->world, enemy_speed, seed,
+		level->paths) != 0)
+		return -1;
+	g = &pl->env->game;
+	g->heatmap = pl->heatmap;
+	pl->random = seed;
+
+	if (p->type == SDLMAN_POLICY_GREEDY) {
+		if (sdlman_bot_init(&pl->bot, g->world, level->paths) != 0)
+			return -1;
+	}
+
+	while (g->status == SDLMAN_GAME_RUNNING &&
+		g->ai.tick < (unsigned long)max_ticks) {
+		switch (p->type) {
+		case SDLMAN_POLICY_GREEDY:
+			action = sdlman_bot_direction(&pl->bot, g->world, &g->player,
+				g->enemy, g->pellet, g->total_pellets);
+			break;
+
+		case SDLMAN_POLICY_LIBRARY:
+			action = p->step(pl->env->obs);
+			break;
+
+		default:
+			action = sdlman_player_random(pl, g);
+			break;
+		}
+		sdlman_env_step(pl->env, action);
+	}
+
+	if (p->type == SDLMAN_POLICY_GREEDY)
+		sdlman_bot_free(&pl->bot);
+
+	if (g->status == SDLMAN_GAME_RUNNING)
+		return SDLMAN_GAME_TIME_OUT;
+	return g->status;
+}
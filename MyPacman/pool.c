@@ -0,0 +1,269 @@
+/* SDL-Man (Environment Pool)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+/* Local definitions. */
+#define SDLMAN_POOL_BENCH_STEPS 2000 /* Per environment. */
+#define SDLMAN_POOL_BENCH_TICKS 3000 /* Tick limit for the bench games. */
+
+
+
+/* Parse a world and compute all of its path table, once. */
+int sdlman_level_load(sdlman_level_t* level, int world_number)
+{
+	char layout_file[SDLMAN_FILENAME_LENGTH];
+
+	snprintf(layout_file, SDLMAN_FILENAME_LENGTH, "world%d.layout",
+		world_number);
+	if (sdlman_game_load_world(layout_file, level->world) != 0)
+		return -1;
+
+	level->paths = sdlman_path_table_create(level->world);
+	if (level->paths == NULL) {
+		fprintf(stderr, "Error: Unable to allocate enemy path table.\n");
+		return -1;
+	}
+	while (!sdlman_path_table_step(level->paths, level->world,
+		SDLMAN_WORLD_TILES))
+		;
+
+	return 0;
+}
+
+
+
+void sdlman_level_free(sdlman_level_t* level)
+{
+	sdlman_path_table_destroy(level->paths);
+	level->paths = NULL;
+}
+
+
+
+/* New game for environment n from the level cache. */
+static int sdlman_pool_reset(sdlman_pool_t* pool, int n)
+{
+	int world_number, enemy_speed;
+	unsigned int seed;
+	sdlman_level_t* level;
+
+	world_number = pool->world_number;
+	if (world_number == 0)
+		world_number = (sdlman_random(&pool->random) % SDLMAN_MAX_WORLD) + 1;
+	enemy_speed = pool->enemy_speed;
+	if (enemy_speed == 0)
+		enemy_speed = (sdlman_random(&pool->random) % SDLMAN_MAX_ENEMY_SPEED) + 1;
+
+	seed = sdlman_random(&pool->random) << 15;
+	seed ^= sdlman_random(&pool->random);
+
+	level = &pool->level[world_number - 1];
+	return sdlman_env_start(pool->env[n], level->world, enemy_speed, seed,
+		level->paths);
+}
+
+
+
+/* Pool of count environments, observation n written at obs + (n *
+ * SDLMAN_ENV_OBS_STRIDE), so obs must be aligned to SDLMAN_ENV_ALIGN. All
+ * worlds used are parsed and all memory is allocated here, stepping does
+ * neither. */
+sdlman_pool_t* sdlman_pool_create(int count, unsigned char* obs,
+	int world_number, int enemy_speed, int max_ticks, unsigned int seed)
+{
+	int i;
+	sdlman_pool_t* pool;
+
+	if (count < 1 || world_number < 0 || world_number > SDLMAN_MAX_WORLD ||
+		enemy_speed < 0 || enemy_speed > SDLMAN_MAX_ENEMY_SPEED) {
+		fprintf(stderr, "Error: Invalid environment pool settings.\n");
+		return NULL;
+	}
+
+	pool = (sdlman_pool_t*)calloc(1, sizeof(sdlman_pool_t));
+	if (pool == NULL) {
+		fprintf(stderr, "Error: Unable to allocate environment pool.\n");
+		return NULL;
+	}
+	pool->world_number = world_number;
+	pool->enemy_speed = enemy_speed;
+	pool->max_ticks = max_ticks;
+	pool->random = seed;
+
+	for (i = 0; i < SDLMAN_MAX_WORLD; i++) {
+		if (world_number != 0 && world_number != i + 1)
+			continue;
+		if (sdlman_level_load(&pool->level[i], i + 1) != 0) {
+			sdlman_pool_destroy(pool);
+			return NULL;
+		}
+	}
+
+	pool->env = (sdlman_env_t**)calloc(count, sizeof(sdlman_env_t*));
+	pool->game = (sdlman_game_t**)calloc(count, sizeof(sdlman_game_t*));
+	if (pool->env == NULL || pool->game == NULL) {
+		fprintf(stderr, "Error: Unable to allocate environment pool.\n");
+		sdlman_pool_destroy(pool);
+		return NULL;
+	}
+
+	for (i = 0; i < count; i++) {
+		pool->env[i] = sdlman_env_create((sdlman_env_obs_t*)(obs +
+			((size_t)i * SDLMAN_ENV_OBS_STRIDE)));
+		if (pool->env[i] == NULL) {
+			sdlman_pool_destroy(pool);
+			return NULL;
+		}
+		pool->count = i + 1;
+		pool->game[i] = &pool->env[i]->game;
+		if (sdlman_pool_reset(pool, i) != 0) {
+			sdlman_pool_destroy(pool);
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+
+
+void sdlman_pool_destroy(sdlman_pool_t* pool)
+{
+	int i;
+
+	if (pool == NULL)
+		return;
+
+	/* Games first, they use the cached path tables. */
+	for (i = 0; i < pool->count; i++)
+		sdlman_env_destroy(pool->env[i]);
+	for (i = 0; i < SDLMAN_MAX_WORLD; i++)
+		sdlman_level_free(&pool->level[i]);
+	free(pool->env);
+	free(pool->game);
+	free(pool);
+}
+
+
+
+/* One loop cycle for every environment. Environments that finish are
+ * started over in place, their observation already shows the new game
+ * and done holds how the old one ended. Returns how many finished. */
+int sdlman_pool_step_all(sdlman_pool_t* pool, int* action, int* reward,
+	int* done)
+{
+	int n, finished;
+	sdlman_game_t* g;
+
+	finished = 0;
+	for (n = 0; n < pool->count; n++) {
+		reward[n] = sdlman_env_step(pool->env[n], action[n]);
+		g = pool->game[n];
+
+		done[n] = g->status;
+		if (done[n] == SDLMAN_GAME_RUNNING && pool->max_ticks > 0 &&
+			g->ai.tick >= (unsigned long)pool->max_ticks)
+			done[n] = SDLMAN_GAME_TIME_OUT;
+		if (done[n] == SDLMAN_GAME_RUNNING)
+			continue;
+
+		finished++;
+		pool->episodes++;
+		sdlman_pool_reset(pool, n); /* Cached worlds, can not fail. */
+	}
+
+	return finished;
+}
+
+
+
+/* Observation planes of every environment, see sdlman_encode_batch(). */
+void sdlman_pool_encode(sdlman_pool_t* pool, unsigned char* out,
+	int batch_stride, int plane_stride, int row_stride)
+{
+	sdlman_encode_batch(pool->game, pool->count, out, batch_stride,
+		plane_stride, row_stride);
+}
+
+
+
+/* Step a pool of count environments over random worlds and enemy speeds
+ * with random moves, and report the throughput. */
+int sdlman_pool_bench(int count)
+{
+	int i, n;
+	unsigned char* obs;
+	int* action, * reward, * done;
+	Uint64 start, elapsed;
+	sdlman_pool_t* pool;
+
+	if (count < 1) {
+		fprintf(stderr, "Error: Need at least one environment.\n");
+		return -1;
+	}
+
+	obs = (unsigned char*)malloc(((size_t)count * SDLMAN_ENV_OBS_STRIDE) +
+		SDLMAN_ENV_ALIGN);
+	action = (int*)malloc(sizeof(int) * count * 3);
+	if (obs == NULL || action == NULL) {
+		fprintf(stderr, "Error: Unable to allocate pool bench.\n");
+		free(obs);
+		free(action);
+		return -1;
+	}
+	reward = action + count;
+	done = reward + count;
+
+	/* Observations start at the first aligned address. */
+	pool = sdlman_pool_create(count, obs + ((SDLMAN_ENV_ALIGN -
+		((size_t)obs % SDLMAN_ENV_ALIGN)) % SDLMAN_ENV_ALIGN), 0, 0,
+		SDLMAN_POOL_BENCH_TICKS, (unsigned int)rand());
+	if (pool == NULL) {
+		free(obs);
+		free(action);
+		return -1;
+	}
+
+	start = sdlman_timer_us();
+	for (i = 0; i < SDLMAN_POOL_BENCH_STEPS; i++) {
+		for (n = 0; n < count; n++) {
+			if (sdlman_character_aligned(&pool->game[n]->player))
+				action[n] = (sdlman_random(&pool->random) % 4) + 1;
+			else
+				action[n] = pool->game[n]->player.moving_direction;
+		}
+		sdlman_pool_step_all(pool, action, reward, done);
+	}
+	elapsed = sdlman_timer_us() - start;
+
+	printf("%d environments, %.0f steps per second, %lu games finished.\n",
+		count, ((double)count * SDLMAN_POOL_BENCH_STEPS * 1000000.0) /
+		(double)(elapsed > 0 ? elapsed : 1), pool->episodes);
+
+	sdlman_pool_destroy(pool);
+	free(obs);
+	free(action);
+	return 0;
+}
@@ -0,0 +1,584 @@
+/* SDL-Man (Software Renderer)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memset() and memcpy(). */
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SDLMAN_RASTER_SSE2
+#include <emmintrin.h> /* For 16-bit sums of pixel blocks. */
+#endif
+
+
+
+/* Local definitions. */
+#define SDLMAN_RASTER_BENCH_RUNS 1000
+#define SDLMAN_RASTER_PATH_LENGTH 256
+#define SDLMAN_RASTER_UNIT_BITS 7
+#define SDLMAN_RASTER_UNIT (1 << SDLMAN_RASTER_UNIT_BITS) /* Weights per cell. */
+#define SDLMAN_RASTER_WHITE 0xffffff
+#define SDLMAN_RASTER_YELLOW 0xffff00
+
+
+
+/* Luma of an 0xRRGGBB colour, BT.601 weights in full range. */
+static Uint8 sdlman_raster_luma(Uint32 c)
+{
+	return (Uint8)(((77 * ((c >> 16) & 0xff)) + (150 * ((c >> 8) & 0xff)) +
+		(29 * (c & 0xff)) + 128) >> 8);
+}
+
+
+
+/* Source cells of the box filtered frame covering each observation cell
+ * along one axis, with weights by overlap adding up to 128, so weighted
+ * sums of pixels fit in 16 bits. Positions are in units where a source
+ * cell is dst long and an observation cell src. */
+static void sdlman_raster_axis(int src, int dst, int* first,
+	Sint16 weight[][SDLMAN_RASTER_TAPS + 1])
+{
+	int i, k, cell, start, end, overlap, total, largest;
+
+	for (i = 0; i < dst; i++) {
+		start = i * src;
+		end = start + src;
+		first[i] = start / dst;
+		total = 0;
+		largest = 0;
+		for (k = 0; k < SDLMAN_RASTER_TAPS; k++) {
+			cell = first[i] + k;
+			overlap = 0;
+			if (cell < src) {
+				overlap = ((cell + 1) * dst < end ? (cell + 1) * dst : end) -
+					(cell * dst > start ? cell * dst : start);
+				if (overlap < 0)
+					overlap = 0;
+			}
+			weight[i][k] = (Sint16)((overlap * SDLMAN_RASTER_UNIT) / src);
+			total += weight[i][k];
+			if (weight[i][k] > weight[i][largest])
+				largest = k;
+		}
+		weight[i][largest] += SDLMAN_RASTER_UNIT - total; /* Rounding. */
+		weight[i][SDLMAN_RASTER_TAPS] = 0;
+	}
+}
+
+
+
+/* Take the sprite pixels out of the atlas, in both colour and gray, and set
+ * up resampling for observations. */
+sdlman_raster_t* sdlman_raster_create(void)
+{
+	int x, y;
+	Uint32 p;
+	sdlman_atlas_t atlas;
+	sdlman_raster_t* r;
+
+	if (sdlman_atlas_load(&atlas) != 0)
+		return NULL;
+
+	r = (sdlman_raster_t*)malloc(sizeof(sdlman_raster_t));
+	if (r == NULL) {
+		fprintf(stderr, "Error: Unable to allocate software renderer.\n");
+		sdlman_atlas_free(&atlas);
+		return NULL;
+	}
+	memcpy(r->rect, atlas.rect, sizeof(r->rect));
+	memset(r->box, 0, sizeof(r->box));
+	memset(r->column, 0, sizeof(r->column));
+
+	if (SDL_LockSurface(atlas.surface) != 0) {
+		fprintf(stderr, "Error: Unable to read sprite atlas: %s\n",
+			SDL_GetError());
+		free(r);
+		sdlman_atlas_free(&atlas);
+		return NULL;
+	}
+	for (y = 0; y < SDLMAN_RASTER_ATLAS_HEIGHT; y++) {
+		for (x = 0; x < SDLMAN_RASTER_ATLAS_WIDTH; x++) {
+			p = ((Uint32*)((Uint8*)atlas.surface->pixels +
+				(y * atlas.surface->pitch)))[x] & 0xffffff;
+			r->color[y][x] = p;
+			r->gray[y][x] = sdlman_raster_luma(p);
+			r->mask[y][x] = (p == SDLMAN_SPRITE_KEY) ? 0 : 0xff;
+		}
+	}
+	SDL_UnlockSurface(atlas.surface);
+	sdlman_atlas_free(&atlas);
+
+	sdlman_raster_axis(SDLMAN_RASTER_WIDTH / SDLMAN_RASTER_BOX,
+		SDLMAN_RASTER_OBS_SIZE, r->first_x, r->weight_x);
+	sdlman_raster_axis(SDLMAN_RASTER_HEIGHT / SDLMAN_RASTER_BOX,
+		SDLMAN_RASTER_OBS_SIZE, r->first_y, r->weight_y);
+	return r;
+}
+
+
+
+void sdlman_raster_destroy(sdlman_raster_t* r)
+{
+	free(r);
+}
+
+
+
+/* Fill a rectangle, clipped to the frame, with one pixel value of the
+ * given size in bytes. */
+static void sdlman_raster_fill(Uint8* pixels, int pitch, int bytes,
+	int x, int y, int w, int h, Uint32 value)
+{
+	int i, j;
+	Uint8* row;
+
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (y < 0) {
+		h += y;
+		y = 0;
+	}
+	if (x + w > SDLMAN_RASTER_WIDTH)
+		w = SDLMAN_RASTER_WIDTH - x;
+	if (y + h > SDLMAN_RASTER_HEIGHT)
+		h = SDLMAN_RASTER_HEIGHT - y;
+	if (w <= 0 || h <= 0)
+		return;
+
+	row = pixels + (y * pitch) + (x * bytes);
+	for (i = 0; i < h; i++) {
+		if (bytes == 1)
+			memset(row, (int)value, w);
+		else
+			for (j = 0; j < w; j++)
+				((Uint32*)row)[j] = value;
+		row += pitch;
+	}
+}
+
+
+
+/* Draw a sprite with its top left corner at x, y, skipping keyed pixels. */
+static void sdlman_raster_sprite(sdlman_raster_t* r, SDL_Rect* src,
+	Uint8* pixels, int pitch, int bytes, int x, int y)
+{
+	int i, j, sx, sy, w, h;
+	Uint8* row;
+
+	sx = src->x;
+	sy = src->y;
+	w = src->w;
+	h = src->h;
+	if (x < 0) {
+		sx -= x;
+		w += x;
+		x = 0;
+	}
+	if (y < 0) {
+		sy -= y;
+		h += y;
+		y = 0;
+	}
+	if (x + w > SDLMAN_RASTER_WIDTH)
+		w = SDLMAN_RASTER_WIDTH - x;
+	if (y + h > SDLMAN_RASTER_HEIGHT)
+		h = SDLMAN_RASTER_HEIGHT - y;
+
+	for (i = 0; i < h; i++) {
+		row = pixels + ((y + i) * pitch) + (x * bytes);
+		for (j = 0; j < w; j++) {
+			if (!r->mask[sy + i][sx + j])
+				continue;
+			if (bytes == 1)
+				row[j] = r->gray[sy + i][sx + j];
+			else
+				((Uint32*)row)[j] = r->color[sy + i][sx + j];
+		}
+	}
+}
+
+
+
+/* Same rules as the game window: black, white walls, white pellets and
+ * yellow boosters, the player and then the enemies left. Animation steps
+ * are the ones the window would draw next, without moving them on. */
+static void sdlman_raster_game(sdlman_raster_t* r, sdlman_game_t* g,
+	Uint8* pixels, int pitch, int bytes)
+{
+	int i, j, size, direction, boosted;
+	Uint32 wall, pellet, booster;
+	Uint8* line;
+	sdlman_pellet_t* p;
+	sdlman_character_t* c;
+
+	if (bytes == 1) {
+		wall = pellet = sdlman_raster_luma(SDLMAN_RASTER_WHITE);
+		booster = sdlman_raster_luma(SDLMAN_RASTER_YELLOW);
+	}
+	else {
+		wall = pellet = SDLMAN_RASTER_WHITE;
+		booster = SDLMAN_RASTER_YELLOW;
+	}
+
+	/* The first line of each row of tiles, copied to the rest of it. */
+	for (i = 0; i < SDLMAN_WORLD_Y_SIZE; i++) {
+		line = pixels + (i * SDLMAN_BLOCK_SIZE * pitch);
+		for (j = 0; j < SDLMAN_WORLD_X_SIZE; j++)
+			sdlman_raster_fill(line, pitch, bytes, j * SDLMAN_BLOCK_SIZE, 0,
+				SDLMAN_BLOCK_SIZE, 1, (g->world[(i * SDLMAN_WORLD_X_SIZE) + j] ==
+				SDLMAN_WORLD_WALL) ? wall : 0);
+		for (j = 1; j < SDLMAN_BLOCK_SIZE; j++)
+			memcpy(line + (j * pitch), line, SDLMAN_RASTER_WIDTH * bytes);
+	}
+
+	for (i = 0; i < g->total_pellets; i++) {
+		p = &g->pellet[i];
+		if (p->consumed)
+			continue;
+		size = p->boost_effect ? SDLMAN_BOOSTER_SIZE : SDLMAN_PELLET_SIZE;
+		sdlman_raster_fill(pixels, pitch, bytes, p->x - (size / 2),
+			p->y - (size / 2), size, size, p->boost_effect ? booster : pellet);
+	}
+
+	boosted = (g->booster_time != 0);
+	c = &g->player;
+	if (c->moving_direction == SDLMAN_DIRECTION_NONE)
+		direction = c->looking_direction;
+	else
+		direction = c->moving_direction;
+	sdlman_raster_sprite(r, &r->rect[0][boosted][direction][c->draw_count],
+		pixels, pitch, bytes, c->x, c->y);
+
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		c = &g->enemy[i];
+		if (c->killed)
+			continue;
+		sdlman_raster_sprite(r,
+			&r->rect[1 + i][boosted][SDLMAN_DIRECTION_NONE][c->draw_count],
+			pixels, pitch, bytes, c->x, c->y);
+	}
+}
+
+
+
+/* Native size frame as 0xRRGGBB pixels, pitch in bytes. */
+void sdlman_raster_draw(sdlman_raster_t* r, sdlman_game_t* g, Uint32* pixels,
+	int pitch)
+{
+	sdlman_raster_game(r, g, (Uint8*)pixels, pitch, 4);
+}
+
+
+
+/* Native size frame as 8-bit luma, pitch in bytes. */
+void sdlman_raster_draw_gray(sdlman_raster_t* r, sdlman_game_t* g,
+	Uint8* pixels, int pitch)
+{
+	sdlman_raster_game(r, g, pixels, pitch, 1);
+}
+
+
+
+/* Mean of each 4 x 4 block of the gray frame. Sixteen columns of four rows
+ * are summed at a time as 16-bit lanes, then pairs of lanes twice over. */
+static void sdlman_raster_box(sdlman_raster_t* r)
+{
+	int x, y, k, sum;
+	Uint8* src, * dst;
+#ifdef SDLMAN_RASTER_SSE2
+	__m128i zero, ones, v, lo, hi;
+#endif
+
+#ifdef SDLMAN_RASTER_SSE2
+	zero = _mm_setzero_si128();
+	ones = _mm_set1_epi16(1);
+#endif
+	for (y = 0; y < SDLMAN_RASTER_HEIGHT / SDLMAN_RASTER_BOX; y++) {
+		src = r->frame[y * SDLMAN_RASTER_BOX];
+		dst = r->box[y];
+		x = 0;
+#ifdef SDLMAN_RASTER_SSE2
+		for (; x + 16 <= SDLMAN_RASTER_WIDTH; x += 16) {
+			lo = hi = zero;
+			for (k = 0; k < SDLMAN_RASTER_BOX; k++) {
+				v = _mm_loadu_si128((__m128i*)(src +
+					(k * SDLMAN_RASTER_WIDTH) + x));
+				lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+				hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+			}
+			/* Pairs of columns, then pairs of pairs. */
+			v = _mm_packs_epi32(_mm_madd_epi16(lo, ones),
+				_mm_madd_epi16(hi, ones));
+			v = _mm_madd_epi16(v, ones);
+			v = _mm_srli_epi32(_mm_add_epi32(v, _mm_set1_epi32(8)), 4);
+			v = _mm_packs_epi32(v, zero);
+			v = _mm_packus_epi16(v, zero);
+			*(Uint32*)(dst + (x / SDLMAN_RASTER_BOX)) =
+				(Uint32)_mm_cvtsi128_si32(v);
+		}
+#endif
+		for (; x < SDLMAN_RASTER_WIDTH; x += SDLMAN_RASTER_BOX) {
+			sum = 0;
+			for (k = 0; k < SDLMAN_RASTER_BOX * SDLMAN_RASTER_BOX; k++)
+				sum += src[((k / SDLMAN_RASTER_BOX) * SDLMAN_RASTER_WIDTH) + x +
+					(k % SDLMAN_RASTER_BOX)];
+			dst[x / SDLMAN_RASTER_BOX] = (Uint8)((sum + 8) >> 4);
+		}
+	}
+}
+
+
+
+/* Resample the box filtered frame down the columns, eight at a time, as
+ * pairs of rows by pairs of weights. */
+static void sdlman_raster_columns(sdlman_raster_t* r)
+{
+	int x, y, k, sum;
+	Uint8* row[SDLMAN_RASTER_TAPS];
+	Sint16* w;
+#ifdef SDLMAN_RASTER_SSE2
+	__m128i zero, w01, w2, a0, a1, a2, lo, hi;
+#endif
+
+#ifdef SDLMAN_RASTER_SSE2
+	zero = _mm_setzero_si128();
+#endif
+	for (y = 0; y < SDLMAN_RASTER_OBS_SIZE; y++) {
+		w = r->weight_y[y];
+		for (k = 0; k < SDLMAN_RASTER_TAPS; k++)
+			row[k] = r->box[r->first_y[y] + k];
+		x = 0;
+#ifdef SDLMAN_RASTER_SSE2
+		w01 = _mm_set1_epi32((w[1] << 16) | w[0]);
+		w2 = _mm_set1_epi32(w[2]);
+		for (; x + 8 <= SDLMAN_RASTER_WIDTH / SDLMAN_RASTER_BOX; x += 8) {
+			a0 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(row[0] + x)), zero);
+			a1 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(row[1] + x)), zero);
+			a2 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(row[2] + x)), zero);
+			lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a0, a1), w01),
+				_mm_madd_epi16(_mm_unpacklo_epi16(a2, zero), w2));
+			hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a0, a1), w01),
+				_mm_madd_epi16(_mm_unpackhi_epi16(a2, zero), w2));
+			_mm_storeu_si128((__m128i*)(r->column[y] + x),
+				_mm_packs_epi32(lo, hi));
+		}
+#endif
+		for (; x < SDLMAN_RASTER_WIDTH / SDLMAN_RASTER_BOX; x++) {
+			sum = 0;
+			for (k = 0; k < SDLMAN_RASTER_TAPS; k++)
+				sum += w[k] * row[k][x];
+			r->column[y][x] = (Sint16)sum;
+		}
+	}
+}
+
+
+
+/* Resample the columns across into the observation. Each output cell is a
+ * product of four weights and four pixels from where its cells start, done
+ * for two cells in one multiply add and summed in pairs of pairs. */
+static void sdlman_raster_rows(sdlman_raster_t* r, Uint8* obs)
+{
+	int x, y, k, sum;
+	Sint16* src, * w;
+#ifdef SDLMAN_RASTER_SSE2
+	__m128i a, b, half;
+	__m128 ab;
+#endif
+
+#ifdef SDLMAN_RASTER_SSE2
+	half = _mm_set1_epi32(1 << ((SDLMAN_RASTER_UNIT_BITS * 2) - 1));
+#endif
+	for (y = 0; y < SDLMAN_RASTER_OBS_SIZE; y++) {
+		src = r->column[y];
+		x = 0;
+#ifdef SDLMAN_RASTER_SSE2
+		for (; x + 4 <= SDLMAN_RASTER_OBS_SIZE; x += 4) {
+			a = _mm_madd_epi16(_mm_unpacklo_epi64(
+				_mm_loadl_epi64((__m128i*)(src + r->first_x[x])),
+				_mm_loadl_epi64((__m128i*)(src + r->first_x[x + 1]))),
+				_mm_loadu_si128((__m128i*)r->weight_x[x]));
+			b = _mm_madd_epi16(_mm_unpacklo_epi64(
+				_mm_loadl_epi64((__m128i*)(src + r->first_x[x + 2])),
+				_mm_loadl_epi64((__m128i*)(src + r->first_x[x + 3]))),
+				_mm_loadu_si128((__m128i*)r->weight_x[x + 2]));
+			/* Even and odd halves of the four products, added. */
+			ab = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b),
+				_MM_SHUFFLE(2, 0, 2, 0));
+			a = _mm_add_epi32(_mm_castps_si128(ab), _mm_castps_si128(
+				_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b),
+				_MM_SHUFFLE(3, 1, 3, 1))));
+			a = _mm_srli_epi32(_mm_add_epi32(a, half),
+				SDLMAN_RASTER_UNIT_BITS * 2);
+			a = _mm_packs_epi32(a, a);
+			*(Uint32*)(obs + x) = (Uint32)_mm_cvtsi128_si32(
+				_mm_packus_epi16(a, a));
+		}
+#endif
+		for (; x < SDLMAN_RASTER_OBS_SIZE; x++) {
+			w = r->weight_x[x];
+			sum = 0;
+			for (k = 0; k < SDLMAN_RASTER_TAPS; k++)
+				sum += w[k] * src[r->first_x[x] + k];
+			obs[x] = (Uint8)((sum + (1 << ((SDLMAN_RASTER_UNIT_BITS * 2) - 1))) >>
+				(SDLMAN_RASTER_UNIT_BITS * 2));
+		}
+		obs += SDLMAN_RASTER_OBS_SIZE;
+	}
+}
+
+
+
+/* Downsampled gray observation, SDLMAN_RASTER_OBS_SIZE square with rows
+ * packed. The frame is reduced by a box filter first, which does most of
+ * the work, and then resampled by area, down and then across. */
+void sdlman_raster_observe(sdlman_raster_t* r, sdlman_game_t* g, Uint8* obs)
+{
+	sdlman_raster_game(r, g, &r->frame[0][0], SDLMAN_RASTER_WIDTH, 1);
+	sdlman_raster_box(r);
+	sdlman_raster_columns(r);
+	sdlman_raster_rows(r, obs);
+}
+
+
+
+static int sdlman_raster_write_image(char* prefix, char* suffix, char* type,
+	Uint8* pixels, int width, int height, int channels)
+{
+	char filename[SDLMAN_RASTER_PATH_LENGTH];
+	FILE* fh;
+	int ok;
+
+	snprintf(filename, SDLMAN_RASTER_PATH_LENGTH, "%s%s", prefix, suffix);
+	fh = fopen(filename, "wb");
+	if (fh == NULL) {
+		fprintf(stderr, "Error: Unable to open image file: %s\n", filename);
+		return -1;
+	}
+	fprintf(fh, "%s\n%d %d\n255\n", type, width, height);
+	ok = (fwrite(pixels, channels, width * height, fh) ==
+		(size_t)(width * height));
+	fclose(fh);
+	if (!ok) {
+		fprintf(stderr, "Error: Unable to write image file: %s\n", filename);
+		return -1;
+	}
+	return 0;
+}
+
+
+
+/* Time drawing frames and observations of random play, and write the last
+ * ones as images if given a prefix. */
+int sdlman_raster_bench(char* world_layout_file, char* image_prefix)
+{
+	int i, failed;
+	char world[SDLMAN_WORLD_TILES];
+	Uint32* color, p;
+	Uint8* rgb, obs[SDLMAN_RASTER_OBS_SIZE * SDLMAN_RASTER_OBS_SIZE];
+	Uint64 start, color_us, gray_us, obs_us;
+	sdlman_game_t* g;
+	sdlman_raster_t* r;
+
+	if (sdlman_game_load_world(world_layout_file, world) != 0)
+		return -1;
+
+	r = sdlman_raster_create();
+	if (r == NULL)
+		return -1;
+	g = (sdlman_game_t*)malloc(sizeof(sdlman_game_t));
+	color = (Uint32*)malloc(SDLMAN_RASTER_WIDTH * SDLMAN_RASTER_HEIGHT * 4);
+	if (g == NULL || color == NULL) {
+		fprintf(stderr, "Error: Unable to allocate software renderer bench.\n");
+		sdlman_raster_destroy(r);
+		free(g);
+		free(color);
+		return -1;
+	}
+	if (sdlman_game_init(g, world, 5, (unsigned int)rand()) != 0) {
+		sdlman_raster_destroy(r);
+		free(g);
+		free(color);
+		return -1;
+	}
+	g->ai.budget_us = 0;
+
+	/* Somewhere into a game, with some pellets eaten. */
+	for (i = 0; i < 200 && g->status == SDLMAN_GAME_RUNNING; i++) {
+		if (sdlman_character_aligned(&g->player))
+			sdlman_game_input(g, (sdlman_game_random(g) % 4) + 1);
+		sdlman_game_step(g);
+	}
+
+	start = sdlman_timer_us();
+	for (i = 0; i < SDLMAN_RASTER_BENCH_RUNS; i++)
+		sdlman_raster_draw(r, g, color, SDLMAN_RASTER_WIDTH * 4);
+	color_us = sdlman_timer_us() - start;
+
+	start = sdlman_timer_us();
+	for (i = 0; i < SDLMAN_RASTER_BENCH_RUNS; i++)
+		sdlman_raster_draw_gray(r, g, &r->frame[0][0], SDLMAN_RASTER_WIDTH);
+	gray_us = sdlman_timer_us() - start;
+
+	start = sdlman_timer_us();
+	for (i = 0; i < SDLMAN_RASTER_BENCH_RUNS; i++)
+		sdlman_raster_observe(r, g, obs);
+	obs_us = sdlman_timer_us() - start;
+
+	printf("%.3f us per colour frame, %.3f us per gray frame, "
+		"%.3f us per %dx%d observation (%s).\n",
+		(double)color_us / SDLMAN_RASTER_BENCH_RUNS,
+		(double)gray_us / SDLMAN_RASTER_BENCH_RUNS,
+		(double)obs_us / SDLMAN_RASTER_BENCH_RUNS,
+		SDLMAN_RASTER_OBS_SIZE, SDLMAN_RASTER_OBS_SIZE,
+#ifdef SDLMAN_RASTER_SSE2
+		"SSE2"
+#else
+		"scalar"
+#endif
+	);
+
+	failed = 0;
+	if (image_prefix != NULL) {
+		/* Packed RGB, reusing the colour frame. */
+		rgb = (Uint8*)color;
+		for (i = 0; i < SDLMAN_RASTER_WIDTH * SDLMAN_RASTER_HEIGHT; i++) {
+			p = color[i]; /* Overlaps what is written. */
+			rgb[(i * 3) + 0] = (Uint8)(p >> 16);
+			rgb[(i * 3) + 1] = (Uint8)(p >> 8);
+			rgb[(i * 3) + 2] = (Uint8)p;
+		}
+		if (sdlman_raster_write_image(image_prefix, ".ppm", "P6", rgb,
+			SDLMAN_RASTER_WIDTH, SDLMAN_RASTER_HEIGHT, 3) != 0)
+			failed = 1;
+		if (sdlman_raster_write_image(image_prefix, ".pgm", "P5", obs,
+			SDLMAN_RASTER_OBS_SIZE, SDLMAN_RASTER_OBS_SIZE, 1) != 0)
+			failed = 1;
+	}
+
+	sdlman_game_free(g);
+	free(g);
+	free(color);
+	sdlman_raster_destroy(r);
+	return failed ? -1 : 0;
+}
@@ -0,0 +1,354 @@
+/* SDL-Man (Renderer)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+/* Surface like the screen, the size of a world, for drawing into once. It
+ * is put in video memory with the screen if possible, for faster blits. */
+SDL_Surface* sdlman_render_surface(SDL_Surface* screen)
+{
+	SDL_Surface* s;
+
+	s = SDL_CreateRGBSurface(screen->flags & SDL_HWSURFACE,
+		SDLMAN_WORLD_X_SIZE * SDLMAN_BLOCK_SIZE,
+		SDLMAN_WORLD_Y_SIZE * SDLMAN_BLOCK_SIZE, screen->format->BitsPerPixel,
+		screen->format->Rmask, screen->format->Gmask, screen->format->Bmask,
+		screen->format->Amask);
+	if (s == NULL)
+		fprintf(stderr, "Error: Unable to create world surface: %s\n",
+			SDL_GetError());
+
+	return s;
+}
+
+
+
+/* Smallest rectangle holding both, where an empty one holds nothing. */
+static void sdlman_rect_union(SDL_Rect* a, SDL_Rect* b, SDL_Rect* u)
+{
+	int x2, y2;
+
+	if (a->w == 0 || a->h == 0) {
+		*u = *b;
+		return;
+	}
+	if (b->w == 0 || b->h == 0) {
+		*u = *a;
+		return;
+	}
+
+	x2 = (a->x + a->w > b->x + b->w) ? a->x + a->w : b->x + b->w;
+	y2 = (a->y + a->h > b->y + b->h) ? a->y + a->h : b->y + b->h;
+	u->x = (a->x < b->x) ? a->x : b->x;
+	u->y = (a->y < b->y) ? a->y : b->y;
+	u->w = x2 - u->x;
+	u->h = y2 - u->y;
+}
+
+
+
+static void sdlman_pellet_rect(sdlman_pellet_t* p, SDL_Rect* r)
+{
+	int size;
+
+	if (p->boost_effect)
+		size = SDLMAN_BOOSTER_SIZE;
+	else
+		size = SDLMAN_PELLET_SIZE;
+	r->w = size;
+	r->h = size;
+	r->x = p->x - (size / 2);
+	r->y = p->y - (size / 2);
+}
+
+
+
+static void sdlman_draw_pellets(SDL_Surface* s, sdlman_pellet_t* p, int total)
+{
+	int i;
+	Uint32 color;
+	SDL_Rect r;
+
+	for (i = 0; i < total; i++) {
+		if (p[i].consumed)
+			continue;
+		if (p[i].boost_effect)
+			color = SDL_MapRGB(s->format, 0xff, 0xff, 0x00); /* Yellow. */
+		else
+			color = SDL_MapRGB(s->format, 0xff, 0xff, 0xff); /* White. */
+		sdlman_pellet_rect(&p[i], &r);
+		SDL_FillRect(s, &r, color);
+	}
+}
+
+
+
+/* Take pellets eaten up to the snapshot out of the background, by putting
+ * the world back under them. The area is added to the player's last drawn
+ * rectangle, so the screen is restored there too. */
+static void sdlman_erase_pellets(sdlman_render_t* r, int eaten)
+{
+	SDL_Rect pr, dst;
+
+	while (r->erased < eaten) {
+		sdlman_pellet_rect(&r->pellet[r->eaten_pellet[r->erased]], &pr);
+		r->erased++;
+		dst = pr;
+		SDL_BlitSurface(r->world, &pr, r->background, &dst);
+		sdlman_rect_union(&r->drawn[0], &pr, &r->drawn[0]);
+	}
+}
+
+
+
+/* Put the world back where sprites were drawn last time. */
+static void sdlman_draw_restore(sdlman_render_t* r)
+{
+	int i;
+	SDL_Rect dst;
+
+	for (i = 0; i < SDLMAN_SPRITES; i++) {
+		if (r->drawn[i].w == 0 || r->drawn[i].h == 0)
+			continue;
+		dst = r->drawn[i]; /* The blit may change it. */
+		SDL_BlitSurface(r->background, &r->drawn[i], r->display->screen, &dst);
+	}
+}
+
+
+
+/* Draw one snapshot. Only what moved is drawn again, unless the screen is
+ * flipped between buffers. */
+static void sdlman_render_frame(sdlman_render_t* r, sdlman_snapshot_t* snap)
+{
+	int i, updates;
+	SDL_Rect sprite[SDLMAN_SPRITES], update[SDLMAN_SPRITES], * src;
+	sdlman_snapshot_sprite_t* s;
+
+	sdlman_erase_pellets(r, snap->eaten);
+
+	if (r->redraw)
+		SDL_BlitSurface(r->background, NULL, r->display->screen, NULL);
+	else
+		sdlman_draw_restore(r);
+
+	for (i = 0; i < SDLMAN_SPRITES; i++) {
+		s = &snap->sprite[i];
+		sprite[i].w = sprite[i].h = 0;
+		if (!s->visible)
+			continue;
+		src = &r->atlas->rect[i][snap->boosted][s->direction][s->step];
+		sprite[i].x = s->x;
+		sprite[i].y = s->y;
+		SDL_BlitSurface(r->atlas->surface, src, r->display->screen,
+			&sprite[i]);
+	}
+
+	if (r->redraw) {
+		sdlman_display_flip(r->display);
+		r->redraw = ((r->display->window->flags & SDL_DOUBLEBUF) ==
+			SDL_DOUBLEBUF);
+	}
+	else {
+		updates = 0;
+		for (i = 0; i < SDLMAN_SPRITES; i++) {
+			sdlman_rect_union(&r->drawn[i], &sprite[i], &update[updates]);
+			if (update[updates].w > 0 && update[updates].h > 0)
+				updates++;
+		}
+		sdlman_display_update(r->display, updates, update);
+	}
+	memcpy(r->drawn, sprite, sizeof(r->drawn));
+	r->frames++;
+}
+
+
+
+/* Draw the latest snapshot whenever there is a new one. Snapshots published
+ * while drawing replace each other, so a slow display only skips frames. */
+static int sdlman_render_thread(void* data)
+{
+	int slot;
+	sdlman_render_t* r;
+
+	r = (sdlman_render_t*)data;
+
+	SDL_mutexP(r->lock);
+	while (1) {
+		while (!r->fresh && !r->quit)
+			SDL_CondWait(r->wake, r->lock);
+		if (!r->fresh)
+			break; /* Quit, with the last one drawn. */
+		slot = r->front;
+		r->front = r->ready;
+		r->ready = slot;
+		r->fresh = 0;
+		SDL_mutexV(r->lock);
+
+		sdlman_render_frame(r, &r->snapshot[r->front]);
+
+		SDL_mutexP(r->lock);
+	}
+	SDL_mutexV(r->lock);
+
+	return 0;
+}
+
+
+
+static void sdlman_render_free(sdlman_render_t* r)
+{
+	if (r->wake != NULL)
+		SDL_DestroyCond(r->wake);
+	if (r->lock != NULL)
+		SDL_DestroyMutex(r->lock);
+	if (r->background != NULL)
+		SDL_FreeSurface(r->background);
+	free(r);
+}
+
+
+
+/* Pellets are drawn once, onto a copy of the world, and taken out of it as
+ * they are eaten. The world surface and atlas must outlive the renderer. */
+sdlman_render_t* sdlman_render_start(sdlman_display_t* display,
+	SDL_Surface* world, sdlman_atlas_t* atlas, sdlman_game_t* g)
+{
+	sdlman_render_t* r;
+
+	r = (sdlman_render_t*)malloc(sizeof(sdlman_render_t));
+	if (r == NULL) {
+		fprintf(stderr, "Error: Unable to allocate renderer.\n");
+		return NULL;
+	}
+	memset(r, 0, sizeof(sdlman_render_t));
+	r->display = display;
+	r->world = world;
+	r->atlas = atlas;
+	r->pellet = g->pellet;
+	r->total_pellets = g->total_pellets;
+	r->back = 0;
+	r->ready = 1;
+	r->front = 2;
+	r->redraw = 1;
+
+	r->background = sdlman_render_surface(display->screen);
+	if (r->background == NULL) {
+		sdlman_render_free(r);
+		return NULL;
+	}
+	SDL_BlitSurface(world, NULL, r->background, NULL);
+	sdlman_draw_pellets(r->background, g->pellet, g->total_pellets);
+
+	r->lock = SDL_CreateMutex();
+	r->wake = SDL_CreateCond();
+	if (r->lock == NULL || r->wake == NULL) {
+		fprintf(stderr, "Error: Unable to create renderer lock: %s\n",
+			SDL_GetError());
+		sdlman_render_free(r);
+		return NULL;
+	}
+
+	r->thread = SDL_CreateThread(sdlman_render_thread, r);
+	if (r->thread == NULL) {
+		fprintf(stderr, "Warning: Unable to start render thread: %s\n",
+			SDL_GetError());
+		fprintf(stderr, "Info: Drawing on the game thread.\n");
+	}
+
+	return r;
+}
+
+
+
+/* Copy out what is needed to draw the game as it is now, and hand it over
+ * to the render thread. Never waits for drawing to finish. */
+void sdlman_render_publish(sdlman_render_t* r, sdlman_game_t* g)
+{
+	int i, slot;
+	sdlman_snapshot_t* snap;
+	sdlman_snapshot_sprite_t* s;
+	sdlman_character_t* c;
+
+	/* Pellets are logged in the order eaten, and only appended to, so the
+	 * render thread can read entries up to a snapshot without locking. */
+	for (i = 0; i < r->total_pellets && r->eaten < g->consumed; i++) {
+		if (g->pellet[i].consumed && !r->logged[i]) {
+			r->logged[i] = 1;
+			r->eaten_pellet[r->eaten++] = i;
+		}
+	}
+
+	snap = &r->snapshot[r->back];
+	snap->boosted = (g->booster_time != 0);
+	snap->eaten = r->eaten;
+	for (i = 0; i < SDLMAN_SPRITES; i++) {
+		c = (i == 0) ? &g->player : &g->enemy[i - 1];
+		s = &snap->sprite[i];
+		s->x = c->x;
+		s->y = c->y;
+		s->visible = (i == 0 || !c->killed);
+		if (i != 0)
+			s->direction = SDLMAN_DIRECTION_NONE;
+		else if (c->moving_direction == SDLMAN_DIRECTION_NONE)
+			s->direction = c->looking_direction;
+		else
+			s->direction = c->moving_direction;
+		s->step = s->visible ? sdlman_sprite_step(c) : 0;
+	}
+	r->published++;
+
+	if (r->thread == NULL) {
+		sdlman_render_frame(r, snap);
+		return;
+	}
+
+	SDL_mutexP(r->lock);
+	slot = r->ready;
+	r->ready = r->back;
+	r->back = slot;
+	r->fresh = 1;
+	SDL_CondSignal(r->wake);
+	SDL_mutexV(r->lock);
+}
+
+
+
+/* Draw the last snapshot, if not already, and stop. */
+void sdlman_render_stop(sdlman_render_t* r)
+{
+	if (r->thread != NULL) {
+		SDL_mutexP(r->lock);
+		r->quit = 1;
+		SDL_CondSignal(r->wake);
+		SDL_mutexV(r->lock);
+		SDL_WaitThread(r->thread, NULL);
+	}
+
+	if (r->frames < r->published)
+		fprintf(stderr, "Info: Drew %lu of %lu frames.\n",
+			r->frames, r->published);
+
+	sdlman_render_free(r);
+}
@@ -0,0 +1,201 @@
+/* SDL-Man (Cooperative Pathing)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memset(). */
+
+
+
+/* Local definitions. */
+#define SDLMAN_RESERVE_START 5 /* Marks the start tile, not a direction. */
+
+
+
+void sdlman_reserve_init(sdlman_reserve_t* r, int enemy_speed)
+{
+	int i;
+
+	if (enemy_speed < 1)
+		enemy_speed = 1;
+	r->ticks_per_step = (SDLMAN_BLOCK_SIZE + enemy_speed - 1) / enemy_speed;
+
+	for (i = 0; i < SDLMAN_RESERVE_SLOTS; i++)
+		r->slot_step[i] = -1;
+	memset(r->owner, 0, sizeof(r->owner));
+
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++)
+		r->plan_length[i] = 0;
+	r->plans = r->blocked = 0;
+}
+
+
+
+void sdlman_reserve_search_init(sdlman_reserve_search_t* s)
+{
+	memset(s->entered, 0, sizeof(s->entered));
+	s->stamp = 0;
+}
+
+
+
+/* Owners of every tile at step, cleared first if the slot was older. */
+static char* sdlman_reserve_slot(sdlman_reserve_t* r, int step)
+{
+	int slot;
+
+	slot = step % SDLMAN_RESERVE_SLOTS;
+	if (r->slot_step[slot] != step) {
+		memset(r->owner[slot], 0, SDLMAN_WORLD_TILES);
+		r->slot_step[slot] = step;
+	}
+
+	return r->owner[slot];
+}
+
+
+
+/* Drop what is left of the plan for enemy n. */
+void sdlman_reserve_release(sdlman_reserve_t* r, int n)
+{
+	int k, step, slot;
+
+	for (k = 0; k < r->plan_length[n]; k++) {
+		step = r->plan_step[n] + k;
+		slot = step % SDLMAN_RESERVE_SLOTS;
+		if (r->slot_step[slot] == step && r->owner[slot][r->plan[n][k]] == n + 1)
+			r->owner[slot][r->plan[n][k]] = 0;
+	}
+	r->plan_length[n] = 0;
+}
+
+
+
+/* Windowed cooperative search for enemy n standing on tile. Tiles cost
+ * cost[tile] to finish from, -1 if not possible, and each step costs
+ * step_cost. Searches as many steps as the window without entering a tile
+ * another enemy has reserved for the same step, or swapping places with one,
+ * then reserves the best path found. Returns the first direction of it, or
+ * none if already there or there is no free path. */
+int sdlman_reserve_plan(sdlman_reserve_t* r, char* world, int n, int tile,
+	unsigned long tick, short* cost, int step_cost)
+{
+	int i, j, k, t, d, next, step, self, total, best, best_k, best_tile;
+	int count[SDLMAN_RESERVE_WINDOW + 1];
+	int frontier[SDLMAN_RESERVE_WINDOW + 1][SDLMAN_WORLD_TILES];
+	char* here, * there;
+	sdlman_reserve_search_t* s;
+
+	s = r->search;
+	self = n + 1;
+	step = (int)(tick / r->ticks_per_step);
+	sdlman_reserve_release(r, n);
+	r->plans++;
+
+	/* Tiles entered are marked with the stamp of this search, so nothing
+	 * needs clearing first. */
+	s->stamp++;
+	if (s->stamp == 0) {
+		memset(s->entered, 0, sizeof(s->entered));
+		s->stamp = 1;
+	}
+
+	/* All moves take one step, so the search goes one step at a time and
+	 * remembers how each tile was entered. */
+	s->entered[0][tile] = s->stamp;
+	s->enter[0][tile] = SDLMAN_RESERVE_START;
+	frontier[0][0] = tile;
+	count[0] = 1;
+	best = best_k = best_tile = -1;
+
+	for (k = 0; k <= SDLMAN_RESERVE_WINDOW; k++) {
+		here = sdlman_reserve_slot(r, step + k);
+		there = NULL;
+		if (k < SDLMAN_RESERVE_WINDOW) {
+			there = sdlman_reserve_slot(r, step + k + 1);
+			count[k + 1] = 0;
+		}
+
+		/* In tile order, so ties are broken the same way every time. */
+		for (i = 1; i < count[k]; i++) {
+			t = frontier[k][i];
+			for (j = i; j > 0 && frontier[k][j - 1] > t; j--)
+				frontier[k][j] = frontier[k][j - 1];
+			frontier[k][j] = t;
+		}
+
+		for (i = 0; i < count[k]; i++) {
+			t = frontier[k][i];
+			if (cost[t] < 0)
+				continue;
+
+			total = (k * step_cost) + cost[t];
+			if (best != -1 && total >= best && step_cost > 0)
+				continue; /* Can only get worse from here. */
+
+			/* Arrived, or at the edge of the window. */
+			if (cost[t] == 0 || k == SDLMAN_RESERVE_WINDOW) {
+				if (best == -1 || total < best) {
+					best = total;
+					best_k = k;
+					best_tile = t;
+				}
+				continue;
+			}
+
+			for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+				next = sdlman_tile_neighbour(t, d);
+				if (world[next] == SDLMAN_WORLD_WALL ||
+					s->entered[k + 1][next] == s->stamp)
+					continue;
+				if (there[next] != 0 && there[next] != self)
+					continue; /* Taken. */
+				if (here[next] != 0 && here[next] != self && here[next] == there[t])
+					continue; /* Would swap places head on. */
+				s->entered[k + 1][next] = s->stamp;
+				s->enter[k + 1][next] = (char)d;
+				frontier[k + 1][count[k + 1]++] = next;
+			}
+		}
+	}
+
+	if (best == -1) {
+		r->blocked++;
+		return SDLMAN_DIRECTION_NONE;
+	}
+
+	/* Walk back to the start, then reserve the path. */
+	t = best_tile;
+	for (k = best_k; k >= 0; k--) {
+		r->plan[n][k] = t;
+		if (k > 0)
+			t = sdlman_tile_neighbour(t,
+				sdlman_direction_opposite[(int)s->enter[k][t]]);
+	}
+	for (k = 0; k <= best_k; k++)
+		sdlman_reserve_slot(r, step + k)[r->plan[n][k]] = (char)self;
+	r->plan_step[n] = step;
+	r->plan_length[n] = best_k + 1;
+
+	if (best_k == 0)
+		return SDLMAN_DIRECTION_NONE;
+	return s->enter[1][r->plan[n][1]];
+}
@@ -0,0 +1,887 @@
+/* SDL-Man (Pellet Route)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+/* Local definitions. */
+#define SDLMAN_ROUTE_TIME 2000000 /* Search time in microseconds. */
+#define SDLMAN_ROUTE_CHUNK 256 /* Stops per preparation job. */
+#define SDLMAN_ROUTE_SEGMENT 3 /* Longest segment moved by Or-opt. */
+#define SDLMAN_ROUTE_CHECK 128 /* Stops looked at between clock checks. */
+#define SDLMAN_ROUTE_MAZE_LOOPS 10 /* Percent, for generated mazes. */
+
+
+
+static const char sdlman_route_letter[5] = { '-', 'U', 'D', 'L', 'R' };
+
+
+
+/* Steps from one tile to another, -1 if there is no way. The search is left
+ * marked in the worker, for walking the path back. */
+static int sdlman_route_distance(sdlman_route_worker_t* w, int from, int to)
+{
+	int d, n, tile, head, tail;
+	sdlman_route_t* r;
+
+	r = w->route;
+	w->seen_stamp++;
+	w->seen[from] = w->seen_stamp;
+	w->distance[from] = 0;
+	if (from == to)
+		return 0;
+
+	head = 0;
+	tail = 0;
+	w->fifo[tail++] = from;
+	while (head < tail) {
+		tile = w->fifo[head++];
+		for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+			n = sdlman_wrap_neighbour(r->width, r->height, tile, d);
+			if (r->world[n] == SDLMAN_WORLD_WALL || w->seen[n] == w->seen_stamp)
+				continue;
+			w->seen[n] = w->seen_stamp;
+			w->distance[n] = w->distance[tile] + 1;
+			if (n == to)
+				return w->distance[n];
+			w->fifo[tail++] = n;
+		}
+	}
+
+	return -1;
+}
+
+
+
+/* Fill in the candidate list of a stop, searching outwards until enough
+ * other stops are found. */
+static void sdlman_route_nearest(sdlman_route_worker_t* w, int s)
+{
+	int d, n, tile, head, tail, found;
+	int *candidate, *candidate_distance;
+	sdlman_route_t* r;
+
+	r = w->route;
+	candidate = r->candidate + (s * SDLMAN_ROUTE_CANDIDATES);
+	candidate_distance = r->candidate_distance + (s * SDLMAN_ROUTE_CANDIDATES);
+	for (found = 0; found < SDLMAN_ROUTE_CANDIDATES; found++)
+		candidate[found] = -1;
+
+	w->seen_stamp++;
+	tile = r->tile[s];
+	w->seen[tile] = w->seen_stamp;
+	w->distance[tile] = 0;
+	head = 0;
+	tail = 0;
+	found = 0;
+	w->fifo[tail++] = tile;
+	while (head < tail && found < SDLMAN_ROUTE_CANDIDATES) {
+		tile = w->fifo[head++];
+		for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+			n = sdlman_wrap_neighbour(r->width, r->height, tile, d);
+			if (r->world[n] == SDLMAN_WORLD_WALL || w->seen[n] == w->seen_stamp)
+				continue;
+			w->seen[n] = w->seen_stamp;
+			w->distance[n] = w->distance[tile] + 1;
+			w->fifo[tail++] = n;
+			if (r->stop[n] != -1 && found < SDLMAN_ROUTE_CANDIDATES) {
+				candidate[found] = r->stop[n];
+				candidate_distance[found] = w->distance[n];
+				found++;
+			}
+		}
+	}
+}
+
+
+
+/* Distance between two stops if either is a candidate of the other, -1 if
+ * not known. Moves only make edges that are known this way. */
+static int sdlman_route_known(sdlman_route_t* r, int a, int b)
+{
+	int i;
+
+	for (i = 0; i < SDLMAN_ROUTE_CANDIDATES; i++) {
+		if (r->candidate[(a * SDLMAN_ROUTE_CANDIDATES) + i] == b)
+			return r->candidate_distance[(a * SDLMAN_ROUTE_CANDIDATES) + i];
+	}
+	for (i = 0; i < SDLMAN_ROUTE_CANDIDATES; i++) {
+		if (r->candidate[(b * SDLMAN_ROUTE_CANDIDATES) + i] == a)
+			return r->candidate_distance[(b * SDLMAN_ROUTE_CANDIDATES) + i];
+	}
+
+	return -1;
+}
+
+
+
+static void sdlman_route_push(sdlman_route_worker_t* w, int s)
+{
+	int stops;
+
+	stops = w->route->stops;
+	if (s < 0 || w->queued[s])
+		return;
+	w->queued[s] = 1;
+	w->queue[(w->queue_head + w->queue_count) % stops] = s;
+	w->queue_count++;
+}
+
+
+
+static int sdlman_route_pop(sdlman_route_worker_t* w)
+{
+	int s;
+
+	s = w->queue[w->queue_head];
+	w->queue_head = (w->queue_head + 1) % w->route->stops;
+	w->queue_count--;
+	w->queued[s] = 0;
+	return s;
+}
+
+
+
+static void sdlman_route_dirty(sdlman_route_worker_t* w, int low, int high)
+{
+	if (low < w->dirty_low)
+		w->dirty_low = low;
+	if (high > w->dirty_high)
+		w->dirty_high = high;
+}
+
+
+
+/* Reverse the stops at positions i + 1 to j, so stop i is followed by stop
+ * j, which is d1 steps away, and stop i + 1 by stop j + 1 at d2 steps. */
+static void sdlman_route_reverse(sdlman_route_worker_t* w, int i, int j,
+	int d1, int d2)
+{
+	int k, m, s, *tour;
+
+	tour = w->tour;
+	sdlman_route_dirty(w, i, j);
+
+	/* Each inner edge now leads the other way. */
+	for (k = j - 1; k > i; k--)
+		w->next_distance[tour[k + 1]] = w->next_distance[tour[k]];
+	w->next_distance[tour[i + 1]] = d2;
+	w->next_distance[tour[i]] = d1;
+
+	for (k = i + 1, m = j; k < m; k++, m--) {
+		s = tour[k];
+		tour[k] = tour[m];
+		tour[m] = s;
+		w->position[tour[k]] = k;
+		w->position[tour[m]] = m;
+	}
+}
+
+
+
+/* 2-opt move joining the stops at positions i and j, if it is shorter. */
+static int sdlman_route_two_opt(sdlman_route_worker_t* w, int i, int j)
+{
+	int d1, d2, gain, last;
+	int* tour;
+	sdlman_route_t* r;
+
+	r = w->route;
+	tour = w->tour;
+	last = r->stops - 1;
+
+	d1 = sdlman_route_known(r, tour[i], tour[j]);
+	if (d1 < 0)
+		return 0;
+	d2 = 0;
+	if (j < last) {
+		d2 = sdlman_route_known(r, tour[i + 1], tour[j + 1]);
+		if (d2 < 0)
+			return 0;
+	}
+
+	gain = w->next_distance[tour[i]] + w->next_distance[tour[j]] - d1 - d2;
+	if (gain <= 0)
+		return 0;
+
+	sdlman_route_reverse(w, i, j, d1, d2);
+	w->length -= gain;
+	sdlman_route_push(w, tour[i]);
+	sdlman_route_push(w, tour[i + 1]);
+	sdlman_route_push(w, tour[j]);
+	if (j < last)
+		sdlman_route_push(w, tour[j + 1]);
+	return 1;
+}
+
+
+
+/* Or-opt move of the stops at positions s to e in between the stops at
+ * positions q and q + 1, reversed or not, if it is shorter. */
+static int sdlman_route_or_opt(sdlman_route_worker_t* w, int s, int e, int q,
+	int reversed)
+{
+	int k, n, first, last, bridge, d_first, d_last, gain, before, after, next;
+	int segment[SDLMAN_ROUTE_SEGMENT], inner[SDLMAN_ROUTE_SEGMENT];
+	int* tour;
+	sdlman_route_t* r;
+
+	r = w->route;
+	tour = w->tour;
+	last = r->stops - 1;
+	first = reversed ? tour[e] : tour[s];
+
+	/* Close the gap, the tour may now end before the segment. */
+	bridge = 0;
+	if (e < last) {
+		bridge = sdlman_route_known(r, tour[s - 1], tour[e + 1]);
+		if (bridge < 0)
+			return 0;
+	}
+	d_first = sdlman_route_known(r, tour[q], first);
+	if (d_first < 0)
+		return 0;
+	d_last = 0;
+	if (q < last) {
+		d_last = sdlman_route_known(r, reversed ? tour[s] : tour[e], tour[q + 1]);
+		if (d_last < 0)
+			return 0;
+	}
+
+	/* The last stop always has 0 as its next distance. */
+	gain = w->next_distance[tour[s - 1]] + w->next_distance[tour[e]] +
+		w->next_distance[tour[q]] - bridge - d_first - d_last;
+	if (gain <= 0)
+		return 0;
+
+	n = e - s + 1;
+	for (k = 0; k < n; k++)
+		segment[k] = reversed ? tour[e - k] : tour[s + k];
+	for (k = 0; k < n - 1; k++)
+		inner[k] = w->next_distance[reversed ? tour[e - k - 1] : tour[s + k]];
+	before = tour[s - 1];
+	next = (e < last) ? tour[e + 1] : -1;
+	after = (q < last) ? tour[q + 1] : -1;
+
+	w->next_distance[before] = bridge;
+	w->next_distance[tour[q]] = d_first;
+	for (k = 0; k < n - 1; k++)
+		w->next_distance[segment[k]] = inner[k];
+	w->next_distance[segment[n - 1]] = d_last;
+
+	if (q < s) {
+		sdlman_route_push(w, tour[q]);
+		memmove(&tour[q + 1 + n], &tour[q + 1], sizeof(int) * (s - 1 - q));
+		for (k = 0; k < n; k++)
+			tour[q + 1 + k] = segment[k];
+		for (k = q + 1; k <= e; k++)
+			w->position[tour[k]] = k;
+		sdlman_route_dirty(w, q, e);
+	}
+	else {
+		sdlman_route_push(w, tour[q]);
+		memmove(&tour[s], &tour[e + 1], sizeof(int) * (q - e));
+		for (k = 0; k < n; k++)
+			tour[q - n + 1 + k] = segment[k];
+		for (k = s; k <= q; k++)
+			w->position[tour[k]] = k;
+		sdlman_route_dirty(w, s - 1, q);
+	}
+
+	w->length -= gain;
+	sdlman_route_push(w, before);
+	sdlman_route_push(w, next);
+	sdlman_route_push(w, after);
+	sdlman_route_push(w, segment[0]);
+	sdlman_route_push(w, segment[n - 1]);
+	return 1;
+}
+
+
+
+/* Try to bring a stop next to each of its candidates, taking the first move
+ * that shortens the tour. */
+static int sdlman_route_improve(sdlman_route_worker_t* w, int a)
+{
+	int i, c, p, q, s, e, n, at_end, last;
+	int* candidate;
+	sdlman_route_t* r;
+
+	r = w->route;
+	last = r->stops - 1;
+	candidate = r->candidate + (a * SDLMAN_ROUTE_CANDIDATES);
+
+	for (i = 0; i < SDLMAN_ROUTE_CANDIDATES && candidate[i] != -1; i++) {
+		c = candidate[i];
+		p = w->position[a];
+		q = w->position[c];
+		if (p > q) {
+			p = q;
+			q = w->position[a];
+		}
+
+		/* New edge between the stops at p and q, as the first or second edge. */
+		if (q > p + 1) {
+			if (sdlman_route_two_opt(w, p, q))
+				return 1;
+			if (p > 0 && sdlman_route_two_opt(w, p - 1, q - 1))
+				return 1;
+		}
+
+		/* Segment with a at either end, moved to either side of c. The start
+		 * stays where it is. */
+		p = w->position[a];
+		q = w->position[c];
+		for (n = 1; n <= SDLMAN_ROUTE_SEGMENT; n++) {
+			for (at_end = 0; at_end <= 1; at_end++) {
+				s = at_end ? p - n + 1 : p;
+				e = at_end ? p : p + n - 1;
+				if (s < 1 || e > last || (q >= s && q <= e))
+					continue;
+				/* After c, with a first. */
+				if ((q < s - 1 || q > e) &&
+					sdlman_route_or_opt(w, s, e, q, at_end))
+					return 1;
+				/* Before c, with a last. */
+				if (q > 0 && (q - 1 < s - 1 || q - 1 > e) &&
+					sdlman_route_or_opt(w, s, e, q - 1, !at_end))
+					return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+
+/* Improve until no stop in the queue has a shorter move, or time is up.
+ * Returns 0 if the time ran out. */
+static int sdlman_route_local_search(sdlman_route_worker_t* w)
+{
+	int a, checked;
+
+	checked = 0;
+	while (w->queue_count > 0) {
+		a = sdlman_route_pop(w);
+		if (sdlman_route_improve(w, a))
+			sdlman_route_push(w, a);
+
+		if (++checked % SDLMAN_ROUTE_CHECK == 0 &&
+			sdlman_timer_us() >= w->route->deadline)
+			return 0;
+	}
+
+	return 1;
+}
+
+
+
+/* Keep the changes since the best tour, or take them back. Only the dirty
+ * positions differ, and they hold the same stops in both. */
+static void sdlman_route_settle(sdlman_route_worker_t* w, int keep)
+{
+	int p, s;
+
+	for (p = w->dirty_low; p <= w->dirty_high; p++) {
+		if (keep) {
+			s = w->tour[p];
+			w->best_tour[p] = s;
+			w->best_next_distance[s] = w->next_distance[s];
+		}
+		else {
+			s = w->best_tour[p];
+			w->tour[p] = s;
+			w->position[s] = p;
+			w->next_distance[s] = w->best_next_distance[s];
+		}
+	}
+
+	if (keep)
+		w->best_length = w->length;
+	else
+		w->length = w->best_length;
+	w->dirty_low = w->route->stops;
+	w->dirty_high = -1;
+	while (w->queue_count > 0)
+		sdlman_route_pop(w);
+}
+
+
+
+/* Random 2-opt move between a stop and one of its candidates, whatever it
+ * costs, to get out of a local optimum. */
+static int sdlman_route_kick(sdlman_route_worker_t* w)
+{
+	int a, c, i, j, d1, d2;
+	sdlman_route_t* r;
+
+	r = w->route;
+	a = (int)((sdlman_random(&w->random) << 15 |
+		sdlman_random(&w->random)) % r->stops);
+	c = r->candidate[(a * SDLMAN_ROUTE_CANDIDATES) +
+		sdlman_random(&w->random) % SDLMAN_ROUTE_CANDIDATES];
+	if (c == -1)
+		return 0;
+
+	i = w->position[a];
+	j = w->position[c];
+	if (i > j) {
+		i = j;
+		j = w->position[a];
+	}
+	if (j <= i + 1)
+		return 0;
+
+	d1 = sdlman_route_known(r, a, c);
+	d2 = 0;
+	if (j < r->stops - 1) {
+		d2 = sdlman_route_distance(w, r->tile[w->tour[i + 1]],
+			r->tile[w->tour[j + 1]]);
+		if (d2 < 0)
+			return 0;
+	}
+
+	w->length += d1 + d2 - w->next_distance[w->tour[i]] -
+		w->next_distance[w->tour[j]];
+	sdlman_route_reverse(w, i, j, d1, d2);
+	sdlman_route_push(w, w->tour[i]);
+	sdlman_route_push(w, w->tour[i + 1]);
+	sdlman_route_push(w, w->tour[j]);
+	if (j < r->stops - 1)
+		sdlman_route_push(w, w->tour[j + 1]);
+	return 1;
+}
+
+
+
+/* Candidate lists and the edges of the first tour, for a chunk of stops. */
+static void sdlman_route_prepare(void* data, int n, int worker)
+{
+	int s, end;
+	sdlman_route_t* r;
+	sdlman_route_worker_t* w;
+
+	r = (sdlman_route_t*)data;
+	w = r->worker[worker];
+	end = (n + 1) * SDLMAN_ROUTE_CHUNK;
+	if (end > r->stops)
+		end = r->stops;
+
+	for (s = n * SDLMAN_ROUTE_CHUNK; s < end; s++) {
+		sdlman_route_nearest(w, s);
+		if (s < r->stops - 1)
+			r->next_distance[r->tour[s]] = sdlman_route_distance(w,
+				r->tile[r->tour[s]], r->tile[r->tour[s + 1]]);
+		else
+			r->next_distance[r->tour[s]] = 0;
+	}
+}
+
+
+
+/* Iterated local search with a sequence of kicks of its own per job. A
+ * worker given a second job goes on from its best tour so far. */
+static void sdlman_route_search(void* data, int n, int worker)
+{
+	int p, s;
+	sdlman_route_t* r;
+	sdlman_route_worker_t* w;
+
+	r = (sdlman_route_t*)data;
+	w = r->worker[worker];
+	w->random = (unsigned int)n * 7919 + 1;
+
+	/* Every job starts looking at a different place. */
+	s = (int)((sdlman_random(&w->random) << 15 |
+		sdlman_random(&w->random)) % r->stops);
+	for (p = 0; p < r->stops; p++)
+		sdlman_route_push(w, w->tour[(s + p) % r->stops]);
+	sdlman_route_local_search(w);
+	sdlman_route_settle(w, w->length <= w->best_length);
+
+	while (sdlman_timer_us() < r->deadline) {
+		if (!sdlman_route_kick(w))
+			continue;
+		w->kicks++;
+		sdlman_route_local_search(w);
+		sdlman_route_settle(w, w->length <= w->best_length);
+	}
+}
+
+
+
+static void sdlman_route_worker_destroy(sdlman_route_worker_t* w)
+{
+	if (w == NULL)
+		return;
+	free(w->tour);
+	free(w->position);
+	free(w->next_distance);
+	free(w->best_tour);
+	free(w->best_next_distance);
+	free(w->queue);
+	free(w->queued);
+	free(w->seen);
+	free(w->distance);
+	free(w->fifo);
+	free(w);
+}
+
+
+
+static sdlman_route_worker_t* sdlman_route_worker_create(sdlman_route_t* r)
+{
+	int tiles;
+	sdlman_route_worker_t* w;
+
+	w = (sdlman_route_worker_t*)calloc(1, sizeof(sdlman_route_worker_t));
+	if (w == NULL)
+		return NULL;
+	w->route = r;
+
+	tiles = r->width * r->height;
+	w->tour = (int*)malloc(sizeof(int) * r->stops);
+	w->position = (int*)malloc(sizeof(int) * r->stops);
+	w->next_distance = (int*)malloc(sizeof(int) * r->stops);
+	w->best_tour = (int*)malloc(sizeof(int) * r->stops);
+	w->best_next_distance = (int*)malloc(sizeof(int) * r->stops);
+	w->queue = (int*)malloc(sizeof(int) * r->stops);
+	w->queued = (char*)calloc(r->stops, 1);
+	w->seen = (int*)calloc(tiles, sizeof(int));
+	w->distance = (int*)malloc(sizeof(int) * tiles);
+	w->fifo = (int*)malloc(sizeof(int) * tiles);
+	if (w->tour == NULL || w->position == NULL || w->next_distance == NULL ||
+		w->best_tour == NULL || w->best_next_distance == NULL ||
+		w->queue == NULL || w->queued == NULL || w->seen == NULL ||
+		w->distance == NULL || w->fifo == NULL) {
+		sdlman_route_worker_destroy(w);
+		return NULL;
+	}
+
+	return w;
+}
+
+
+
+void sdlman_route_destroy(sdlman_route_t* r)
+{
+	int i;
+
+	if (r == NULL)
+		return;
+	for (i = 0; i < SDLMAN_PARALLEL_MAX_WORKERS; i++)
+		sdlman_route_worker_destroy(r->worker[i]);
+	free(r->tile);
+	free(r->stop);
+	free(r->candidate);
+	free(r->candidate_distance);
+	free(r->tour);
+	free(r->next_distance);
+	free(r);
+}
+
+
+
+/* Find the stops of a width by height world, which must be kept until the
+ * route is destroyed. The stops are numbered in depth first order from the
+ * player, which is also the first tour. Unreachable pellets are left out. */
+sdlman_route_t* sdlman_route_create(char* world, int width, int height)
+{
+	int i, d, n, tile, top, tiles;
+	int* stack;
+	char *direction, *visited;
+	sdlman_route_t* r;
+
+	r = (sdlman_route_t*)calloc(1, sizeof(sdlman_route_t));
+	if (r == NULL) {
+		fprintf(stderr, "Error: Unable to allocate pellet route.\n");
+		return NULL;
+	}
+	r->world = world;
+	r->width = width;
+	r->height = height;
+	tiles = width * height;
+
+	for (tile = 0; tile < tiles; tile++) {
+		if (world[tile] == SDLMAN_WORLD_PLAYER)
+			break;
+	}
+	if (tile == tiles) {
+		fprintf(stderr, "Error: No player in world.\n");
+		sdlman_route_destroy(r);
+		return NULL;
+	}
+
+	r->tile = (int*)malloc(sizeof(int) * tiles);
+	r->stop = (int*)malloc(sizeof(int) * tiles);
+	stack = (int*)malloc(sizeof(int) * tiles);
+	direction = (char*)malloc(tiles);
+	visited = (char*)calloc(tiles, 1);
+	if (r->tile == NULL || r->stop == NULL || stack == NULL ||
+		direction == NULL || visited == NULL) {
+		fprintf(stderr, "Error: Unable to allocate pellet route stops.\n");
+		free(stack);
+		free(direction);
+		free(visited);
+		sdlman_route_destroy(r);
+		return NULL;
+	}
+	for (i = 0; i < tiles; i++)
+		r->stop[i] = -1;
+
+	/* Depth first from the player, numbering stops as they are found. */
+	r->tile[0] = tile;
+	r->stop[tile] = 0;
+	r->stops = 1;
+	visited[tile] = 1;
+	direction[tile] = SDLMAN_DIRECTION_NONE;
+	top = 0;
+	stack[top++] = tile;
+	while (top > 0) {
+		tile = stack[top - 1];
+		if (direction[tile] == SDLMAN_DIRECTION_RIGHT) {
+			top--;
+			continue;
+		}
+		d = ++direction[tile];
+		n = sdlman_wrap_neighbour(r->width, r->height, tile, d);
+		if (visited[n] || world[n] == SDLMAN_WORLD_WALL)
+			continue;
+		visited[n] = 1;
+		direction[n] = SDLMAN_DIRECTION_NONE;
+		if (world[n] == SDLMAN_WORLD_PELLET || world[n] == SDLMAN_WORLD_BOOSTER) {
+			r->tile[r->stops] = n;
+			r->stop[n] = r->stops;
+			r->stops++;
+		}
+		stack[top++] = n;
+	}
+	free(stack);
+	free(direction);
+	free(visited);
+
+	r->candidate = (int*)malloc(sizeof(int) * r->stops *
+		SDLMAN_ROUTE_CANDIDATES);
+	r->candidate_distance = (int*)malloc(sizeof(int) * r->stops *
+		SDLMAN_ROUTE_CANDIDATES);
+	r->tour = (int*)malloc(sizeof(int) * r->stops);
+	r->next_distance = (int*)malloc(sizeof(int) * r->stops);
+	if (r->candidate == NULL || r->candidate_distance == NULL ||
+		r->tour == NULL || r->next_distance == NULL) {
+		fprintf(stderr, "Error: Unable to allocate pellet route tour.\n");
+		sdlman_route_destroy(r);
+		return NULL;
+	}
+	for (i = 0; i < r->stops; i++)
+		r->tour[i] = i;
+
+	r->workers = sdlman_cpu_count();
+	if (r->workers > SDLMAN_PARALLEL_MAX_WORKERS)
+		r->workers = SDLMAN_PARALLEL_MAX_WORKERS;
+	for (i = 0; i < r->workers; i++) {
+		r->worker[i] = sdlman_route_worker_create(r);
+		if (r->worker[i] == NULL) {
+			fprintf(stderr, "Error: Unable to allocate pellet route worker.\n");
+			sdlman_route_destroy(r);
+			return NULL;
+		}
+	}
+
+	return r;
+}
+
+
+
+/* Search for a short tour for up to time_us microseconds on all processors,
+ * each worker kicking its own copy around. Returns the tour length. */
+int sdlman_route_solve(sdlman_route_t* r, int time_us)
+{
+	int i, p, s, best, jobs;
+	sdlman_route_worker_t* w;
+
+	jobs = (r->stops + SDLMAN_ROUTE_CHUNK - 1) / SDLMAN_ROUTE_CHUNK;
+	if (sdlman_parallel_run(r->workers, jobs, sdlman_route_prepare, r) < 0)
+		return -1;
+
+	r->initial_length = 0;
+	for (i = 0; i < r->stops; i++)
+		r->initial_length += r->next_distance[i];
+	r->length = r->initial_length;
+	if (r->stops < 3)
+		return r->length; /* Nothing to choose. */
+
+	/* Every worker starts from the first tour. */
+	for (i = 0; i < r->workers; i++) {
+		w = r->worker[i];
+		for (p = 0; p < r->stops; p++) {
+			s = r->tour[p];
+			w->tour[p] = w->best_tour[p] = s;
+			w->position[s] = p;
+			w->next_distance[s] = w->best_next_distance[s] = r->next_distance[s];
+			w->queued[s] = 0;
+		}
+		w->length = w->best_length = r->initial_length;
+		w->queue_head = w->queue_count = 0;
+		w->dirty_low = r->stops;
+		w->dirty_high = -1;
+		w->kicks = 0;
+	}
+
+	r->deadline = sdlman_timer_us() + time_us;
+	if (sdlman_parallel_run(r->workers, r->workers, sdlman_route_search, r) < 0)
+		return -1;
+
+	best = 0;
+	r->kicks = 0;
+	for (i = 0; i < r->workers; i++) {
+		r->kicks += r->worker[i]->kicks;
+		if (r->worker[i]->best_length < r->worker[best]->best_length)
+			best = i;
+	}
+	memcpy(r->tour, r->worker[best]->best_tour, sizeof(int) * r->stops);
+	memcpy(r->next_distance, r->worker[best]->best_next_distance,
+		sizeof(int) * r->stops);
+	r->length = r->worker[best]->best_length;
+
+	return r->length;
+}
+
+
+
+/* Write the tour as one line of moves, U, D, L or R, from the player. */
+int sdlman_route_write(sdlman_route_t* r, FILE* fh)
+{
+	int i, d, n, tile, steps, length;
+	char* moves;
+	sdlman_route_worker_t* w;
+
+	moves = (char*)malloc(r->width * r->height);
+	if (moves == NULL) {
+		fprintf(stderr, "Error: Unable to allocate pellet route moves.\n");
+		return -1;
+	}
+
+	w = r->worker[0];
+	for (i = 0; i < r->stops - 1; i++) {
+		tile = r->tile[r->tour[i + 1]];
+		length = sdlman_route_distance(w, r->tile[r->tour[i]], tile);
+		if (length < 0) {
+			free(moves);
+			return -1;
+		}
+
+		/* Walk back along the search, filling in moves from the end. */
+		for (steps = length; steps > 0; ) {
+			for (d = SDLMAN_DIRECTION_UP; d <= SDLMAN_DIRECTION_RIGHT; d++) {
+				n = sdlman_wrap_neighbour(r->width, r->height, tile, d);
+				if (w->seen[n] == w->seen_stamp && w->distance[n] == steps - 1)
+					break;
+			}
+			moves[--steps] = sdlman_route_letter[sdlman_direction_opposite[d]];
+			tile = n;
+		}
+		fwrite(moves, 1, length, fh);
+	}
+	fputc('\n', fh);
+
+	free(moves);
+	return 0;
+}
+
+
+
+/* Find a short route through all pellets of a layout file, or of a generated
+ * size by size maze if the source is a number, and optionally write it. */
+int sdlman_route_tool(char* source, char* path_file)
+{
+	int size, width, height, length;
+	char* world;
+	Uint64 start;
+	FILE* fh;
+	sdlman_route_t* r;
+
+	size = atoi(source);
+	if (size > 0) {
+		if (size < 3) {
+			fprintf(stderr, "Error: Maze size must be at least 3.\n");
+			return -1;
+		}
+		width = height = size;
+	}
+	else {
+		width = SDLMAN_WORLD_X_SIZE;
+		height = SDLMAN_WORLD_Y_SIZE;
+	}
+
+	world = (char*)malloc(width * height);
+	if (world == NULL) {
+		fprintf(stderr, "Error: Unable to allocate %dx%d world.\n", width, height);
+		return -1;
+	}
+	if (size > 0) {
+		if (sdlman_maze_generate(world, width, height, (unsigned int)size,
+			SDLMAN_ROUTE_MAZE_LOOPS) != 0) {
+			free(world);
+			return -1;
+		}
+	}
+	else if (sdlman_game_load_world(source, world) != 0) {
+		free(world);
+		return -1;
+	}
+
+	start = sdlman_timer_us();
+	r = sdlman_route_create(world, width, height);
+	if (r == NULL) {
+		free(world);
+		return -1;
+	}
+	length = sdlman_route_solve(r, SDLMAN_ROUTE_TIME);
+	if (length < 0) {
+		sdlman_route_destroy(r);
+		free(world);
+		return -1;
+	}
+	printf("%dx%d world: %d pellets, tour of %d steps (%d depth first), "
+		"%d workers, %lu kicks, %.1f s.\n", width, height, r->stops - 1,
+		length, r->initial_length, r->workers, r->kicks,
+		(double)(sdlman_timer_us() - start) / 1000000.0);
+
+	if (path_file != NULL) {
+		fh = fopen(path_file, "w");
+		if (fh == NULL) {
+			fprintf(stderr, "Error: Cannot open file '%s' for writing.\n",
+				path_file);
+			sdlman_route_destroy(r);
+			free(world);
+			return -1;
+		}
+		sdlman_route_write(r, fh);
+		fclose(fh);
+	}
+
+	sdlman_route_destroy(r);
+	free(world);
+	return 0;
+}
@@ -39,8 +39,730 @@
 
 #define SDLMAN_GAME_SPEED 20
 
+#define SDLMAN_FILENAME_LENGTH 16
+#define SDLMAN_MAX_ENEMY_SPEED 9
+#define SDLMAN_MAX_WORLD 5
+
+#define SDLMAN_CHARACTER_SIZE 26
+#define SDLMAN_ENEMY_COUNT 4
+#define SDLMAN_MAX_PELLET 300 /* 15 x 20 */
+#define SDLMAN_PELLET_SIZE 4 /* In pixels, when drawn. */
+#define SDLMAN_BOOSTER_SIZE 6
+#define SDLMAN_MAX_PLAYER_SPEED 5
+#define SDLMAN_BOOSTER_TIME 120 /* In loop cycles. */
+#define SDLMAN_AUTOPILOT_TIME 30000 /* In loop cycles, for unattended play. */
+
+#define SDLMAN_SCORE_PELLET 2
+#define SDLMAN_SCORE_FINISH 100
+#define SDLMAN_SCORE_ENEMY -25 /* Penalty for killing enemies. */
+
+#define SDLMAN_WORLD_AIR ' '
+#define SDLMAN_WORLD_WALL '#'
+#define SDLMAN_WORLD_PLAYER 'P'
+#define SDLMAN_WORLD_ENEMY 'E'
+#define SDLMAN_WORLD_PELLET '.'
+#define SDLMAN_WORLD_BOOSTER '*'
+
+#define SDLMAN_WORLD_TILES (SDLMAN_WORLD_X_SIZE * SDLMAN_WORLD_Y_SIZE)
+
+enum {
+  SDLMAN_DIRECTION_NONE = 0,
+  SDLMAN_DIRECTION_UP = 1,
+  SDLMAN_DIRECTION_DOWN = 2,
+  SDLMAN_DIRECTION_LEFT = 3,
+  SDLMAN_DIRECTION_RIGHT = 4,
+};
+
+typedef struct sdlman_character_s {
+  int x, y; /* World co-ordinates. */
+  int moving_direction, looking_direction;
+  int speed;
+  int draw_count; /* Used for animation. */
+  int killed;
+} sdlman_character_t;
+
+typedef struct sdlman_pellet_s {
+  int x, y;
+  int consumed;
+  int boost_effect;
+} sdlman_pellet_t;
+
+enum {
+  SDLMAN_FLEE_DONE = 0,
+  SDLMAN_FLEE_SEARCH = 1,
+  SDLMAN_FLEE_RELAX = 2,
+  SDLMAN_FLEE_POINT = 3,
+};
+
+/* Flee flow field, cached until the player changes tile. */
+typedef struct sdlman_flee_field_s {
+  int player_tile; /* Tile the field was computed for, -1 if none. */
+  int distance[SDLMAN_WORLD_TILES]; /* Player distance map, -1 if unreachable. */
+  int value[SDLMAN_WORLD_TILES]; /* Relaxed, inverted distance. */
+  char direction[SDLMAN_WORLD_TILES]; /* Direction to flee in per tile. */
+  /* Resumable computation state. */
+  int stage, target, head, tail, seed, queue_head, queue_tail, index;
+  int order[SDLMAN_WORLD_TILES], queue[SDLMAN_WORLD_TILES];
+} sdlman_flee_field_t;
+
+/* Per level path data, indexed by [target tile][from tile]. */
+typedef struct sdlman_path_table_s {
+  short distance[SDLMAN_WORLD_TILES][SDLMAN_WORLD_TILES]; /* -1 if none. */
+  char next[SDLMAN_WORLD_TILES][SDLMAN_WORLD_TILES]; /* First direction. */
+  int corner[4]; /* Open tiles closest to each world corner. */
+  int rows; /* Targets computed so far, the rest answer none. */
+  struct sdlman_bitfill_s *fill; /* Open tile bitmap for the rows. */
+} sdlman_path_table_t;
+
+#define SDLMAN_RESERVE_WINDOW 8 /* Planning horizon, in steps. */
+#define SDLMAN_RESERVE_SLOTS (SDLMAN_RESERVE_WINDOW + 2)
+
+/* Scratch of the reservation search, kept out of the game state so copies
+ * stay small. Copies share it, so one per thread that plays them. */
+typedef struct sdlman_reserve_search_s {
+  unsigned int stamp; /* Of the last search, marks the tiles it entered. */
+  unsigned int entered[SDLMAN_RESERVE_WINDOW + 1][SDLMAN_WORLD_TILES];
+  char enter[SDLMAN_RESERVE_WINDOW + 1][SDLMAN_WORLD_TILES]; /* Direction. */
+} sdlman_reserve_search_t;
+
+/* Space-time reservations of enemy paths. One step is the time it takes an
+ * enemy to cross a tile, and slots are reused in a ring as steps go by. */
+typedef struct sdlman_reserve_s {
+  int ticks_per_step;
+  int slot_step[SDLMAN_RESERVE_SLOTS]; /* Step held by each slot, -1 if none. */
+  char owner[SDLMAN_RESERVE_SLOTS][SDLMAN_WORLD_TILES]; /* Enemy + 1, or 0. */
+  int plan[SDLMAN_ENEMY_COUNT][SDLMAN_RESERVE_WINDOW + 1]; /* Reserved tiles. */
+  int plan_step[SDLMAN_ENEMY_COUNT], plan_length[SDLMAN_ENEMY_COUNT];
+  sdlman_reserve_search_t *search; /* Not part of the state. */
+  unsigned long plans; /* Searches done. */
+  unsigned long blocked; /* Searches without any free path. */
+} sdlman_reserve_t;
+
+enum {
+  SDLMAN_PERSONALITY_CHASE = 0, /* Goes straight for the player. */
+  SDLMAN_PERSONALITY_AMBUSH = 1, /* Aims four tiles ahead of the player. */
+  SDLMAN_PERSONALITY_PATROL = 2, /* Walks between the corners. */
+  SDLMAN_PERSONALITY_SHY = 3, /* Chases, but backs off when too close. */
+};
+
+/* Enemy AI state for one level. */
+typedef struct sdlman_ai_s {
+  sdlman_path_table_t *paths;
+  sdlman_flee_field_t flee[2]; /* Front is served while back is computed. */
+  int flee_front;
+  short flee_cost[SDLMAN_WORLD_TILES]; /* Front field as reservation costs. */
+  int flee_cost_tile; /* Player tile behind flee_cost, -1 if none. */
+  int scatter; /* Non-zero during scatter phase. */
+  int phase_time; /* Loop cycles left of current phase. */
+  int personality[SDLMAN_ENEMY_COUNT];
+  int patrol_corner[SDLMAN_ENEMY_COUNT];
+  int budget_us; /* Microseconds of path work per loop cycle, 0 for all. */
+  unsigned long budget_ticks; /* Loop cycles with path work pending. */
+  unsigned long budget_hits; /* Loop cycles where the budget ran out. */
+  sdlman_reserve_t reserve; /* Keeps enemies from planning into each other. */
+  unsigned long tick; /* Loop cycles since the level started. */
+  int shared_paths; /* Path table and search belong to another copy. */
+} sdlman_ai_t;
+
+enum {
+  SDLMAN_GAME_RUNNING = 0,
+  SDLMAN_GAME_KILLED = 1,
+  SDLMAN_GAME_CLEARED = 2,
+  SDLMAN_GAME_TIME_OUT = 3, /* Never set by the game, for tick limits. */
+};
+
+#define SDLMAN_GAME_CHOMP 0x1 /* Step event, something was eaten. */
+
+#define SDLMAN_HEATMAP_CHARACTERS (1 + SDLMAN_ENEMY_COUNT) /* Player first. */
+
+/* Everything that changes while a level is played, without graphics or
+ * sound, so it can be copied and stepped on its own. */
+typedef struct sdlman_game_s {
+  char world[SDLMAN_WORLD_TILES];
+  sdlman_character_t player, enemy[SDLMAN_ENEMY_COUNT];
+  sdlman_pellet_t pellet[SDLMAN_MAX_PELLET];
+  int total_pellets, consumed;
+  int booster_time; /* Loop cycles left of booster effect. */
+  int enemy_speed;
+  int bonus; /* Finish bonus and enemy penalties so far. */
+  int status;
+  unsigned int random; /* Random generator state. */
+  sdlman_ai_t ai;
+  unsigned long enemy_moves, enemy_pushes; /* Push-backs between enemies. */
+  struct sdlman_heatmap_s *heatmap; /* Counted into when not NULL. */
+  int heat_tile[SDLMAN_HEATMAP_CHARACTERS]; /* Last tiles counted. */
+} sdlman_game_t;
+
+/* Autopilot for the player, used for unattended runs. */
+typedef struct sdlman_bot_s {
+  sdlman_path_table_t *paths; /* Complete table to look distances up in. */
+  struct sdlman_bitfill_s *fill; /* Distance maps without one. */
+  int pellet_distance[SDLMAN_WORLD_TILES]; /* To nearest pellet left. */
+  int enemy_distance[SDLMAN_WORLD_TILES]; /* To nearest enemy. */
+  int sources[SDLMAN_MAX_PELLET]; /* Tiles of the pellets left. */
+  int pellets_left; /* Behind pellet_distance, -1 before the first. */
+  int enemies, enemy_tile[SDLMAN_ENEMY_COUNT]; /* Behind enemy_distance. */
+} sdlman_bot_t;
+
+enum {
+  SDLMAN_PILOT_NONE = 0, /* Keyboard. */
+  SDLMAN_PILOT_GREEDY = 1, /* Nearest pellet autopilot. */
+  SDLMAN_PILOT_MCTS = 2, /* Tree search. */
+};
+
+#define SDLMAN_MCTS_MAX_WORKERS 16
+#define SDLMAN_MCTS_NODES 16384 /* Per worker. */
+
+/* Tree search node, statistics only. The game state of a node is found by
+ * playing the moves down from the root again. */
+typedef struct sdlman_mcts_node_s {
+  int child[4]; /* Node per direction, 0 if not expanded. */
+  int visits;
+  double value; /* Sum of returns through here. */
+} sdlman_mcts_node_t;
+
+/* One search thread, with its own tree from the same root (root parallel). */
+typedef struct sdlman_mcts_worker_s {
+  struct sdlman_mcts_s *mcts;
+  SDL_Thread *thread; /* NULL for the first, which runs on the caller. */
+  SDL_sem *start, *done;
+  sdlman_game_t game; /* The copy being played. */
+  sdlman_mcts_node_t node[SDLMAN_MCTS_NODES];
+  int nodes;
+  unsigned int random; /* For rollouts, the game keeps its own. */
+  sdlman_reserve_search_t search; /* For the enemies in the copy. */
+  unsigned long iterations;
+} sdlman_mcts_worker_t;
+
+typedef struct sdlman_mcts_s {
+  int workers;
+  sdlman_mcts_worker_t *worker[SDLMAN_MCTS_MAX_WORKERS];
+  sdlman_game_t root; /* Shared and read only while searching. */
+  Uint64 deadline;
+  int budget_us; /* Search time per decision. */
+  int quit;
+  unsigned long decisions, iterations; /* Totals, for reporting. */
+} sdlman_mcts_t;
+
+#define SDLMAN_ENV_ALIGN 32 /* Observation buffers must be aligned to this. */
+#define SDLMAN_ENV_MASK_WORDS ((SDLMAN_WORLD_TILES + 31) / 32)
+#define SDLMAN_ENV_ENTITIES (1 + SDLMAN_ENEMY_COUNT) /* Player first. */
+
+/* Observation written in place by the environment, owned by the caller.
+ * Tiles are numbered row by row, bit (tile % 32) of word (tile / 32). */
+typedef struct sdlman_env_obs_s {
+  Uint32 pellet[SDLMAN_ENV_MASK_WORDS]; /* Tiles with a pellet left. */
+  Uint32 booster[SDLMAN_ENV_MASK_WORDS]; /* Tiles with a booster left. */
+  unsigned char wall[SDLMAN_WORLD_TILES]; /* 1 for walls, 0 otherwise. */
+  int x[SDLMAN_ENV_ENTITIES], y[SDLMAN_ENV_ENTITIES]; /* World co-ordinates. */
+  int direction[SDLMAN_ENV_ENTITIES]; /* Moving, or looking if standing. */
+  int killed[SDLMAN_ENV_ENTITIES];
+  int booster_time; /* Loop cycles left of booster effect. */
+  int reward; /* From the last step, unscaled score points. */
+  int status; /* SDLMAN_GAME_*. */
+  int tick;
+} sdlman_env_obs_t;
+
+/* Game stepped directly by a trainer, without graphics, sound or delays. */
+typedef struct sdlman_env_s {
+  sdlman_game_t game;
+  sdlman_env_obs_t *obs;
+  unsigned char *own_obs; /* Memory behind obs, if not the caller's. */
+  int pellet_tile[SDLMAN_MAX_PELLET];
+  int points; /* Unscaled score so far, for rewards. */
+  int loaded;
+  sdlman_reserve_search_t search; /* For games on a shared path table. */
+} sdlman_env_t;
+
+/* Distance between observations in a pool, keeping each one aligned. */
+#define SDLMAN_ENV_OBS_STRIDE (((sizeof(sdlman_env_obs_t) + \
+  SDLMAN_ENV_ALIGN - 1) / SDLMAN_ENV_ALIGN) * SDLMAN_ENV_ALIGN)
+
+/* Parsed world with its complete path table, for resets without I/O. */
+typedef struct sdlman_level_s {
+  char world[SDLMAN_WORLD_TILES];
+  sdlman_path_table_t *paths; /* NULL if not loaded. */
+} sdlman_level_t;
+
+/* Environments stepped together, starting over by themselves. */
+typedef struct sdlman_pool_s {
+  int count;
+  sdlman_env_t **env;
+  sdlman_game_t **game; /* Of each environment, for the encoder. */
+  sdlman_level_t level[SDLMAN_MAX_WORLD];
+  int world_number, enemy_speed; /* 0 for a random pick on each reset. */
+  int max_ticks; /* 0 for no limit. */
+  unsigned int random;
+  unsigned long episodes;
+} sdlman_pool_t;
+
+/* Observation planes, one byte per tile, for learning agents. */
+enum {
+  SDLMAN_PLANE_WALL = 0,
+  SDLMAN_PLANE_PELLET = 1,
+  SDLMAN_PLANE_BOOSTER = 2,
+  SDLMAN_PLANE_PLAYER = 3,
+  SDLMAN_PLANE_ENEMY = 4, /* One plane for each enemy from here. */
+  SDLMAN_PLANE_FRIGHTENED = SDLMAN_PLANE_ENEMY + SDLMAN_ENEMY_COUNT,
+  SDLMAN_ENCODE_PLANES,
+};
+
+#define SDLMAN_ENCODE_ON 255 /* Plane value for set tiles. */
+
+#define SDLMAN_PARALLEL_MAX_WORKERS 64
+
+typedef void (*sdlman_job_t)(void *data, int n, int worker);
+
+/* Jobs handed out in order to worker threads. */
+typedef struct sdlman_parallel_s {
+  SDL_mutex *lock;
+  int next, jobs;
+  sdlman_job_t job;
+  void *data;
+} sdlman_parallel_t;
+
+typedef struct sdlman_parallel_worker_s {
+  sdlman_parallel_t *parallel;
+  SDL_Thread *thread;
+  int index;
+} sdlman_parallel_worker_t;
+
+enum {
+  SDLMAN_POLICY_RANDOM = 0, /* Random turns, as a baseline. */
+  SDLMAN_POLICY_GREEDY = 1, /* The autopilot bot. */
+  SDLMAN_POLICY_LIBRARY = 2, /* Step callback from a shared library. */
+};
+
+#define SDLMAN_POLICY_NAME_LENGTH 24
+#define SDLMAN_POLICY_SYMBOL "sdlman_policy_step"
+
+/* Step callback exported by policy libraries, returning the direction to
+ * press (or none) for an observation. Called from several threads at once. */
+typedef int (*sdlman_policy_step_t)(const sdlman_env_obs_t *obs);
+
+typedef struct sdlman_policy_s {
+  char name[SDLMAN_POLICY_NAME_LENGTH];
+  int type;
+  void *object; /* Loaded library, if any. */
+  sdlman_policy_step_t step;
+} sdlman_policy_t;
+
+/* Game and policy state for playing on one thread. */
+typedef struct sdlman_player_s {
+  sdlman_env_t *env;
+  sdlman_bot_t bot;
+  unsigned int random;
+  struct sdlman_heatmap_s *heatmap; /* Given to each game, may be NULL. */
+} sdlman_player_t;
+
+/* Tiles visited by each character and where the player died, summed over
+ * many games of the same world. A visit is counted on entering a tile. */
+typedef struct sdlman_heatmap_s {
+  unsigned int visits[SDLMAN_HEATMAP_CHARACTERS][SDLMAN_WORLD_TILES];
+  unsigned int deaths[SDLMAN_WORLD_TILES];
+  unsigned int games;
+} sdlman_heatmap_t;
+
+#define SDLMAN_ROUTE_CANDIDATES 10 /* Nearest other stops kept per stop. */
+
+/* Local search state of one worker thread, on its own copy of the tour. */
+typedef struct sdlman_route_worker_s {
+  struct sdlman_route_s *route;
+  int *tour, *position; /* Stop by position, position by stop. */
+  int *next_distance; /* By stop, to the next one, 0 for the last. */
+  int *best_tour, *best_next_distance;
+  int *queue; /* Stops left to look at, ring buffer. */
+  char *queued;
+  int queue_head, queue_count;
+  int *seen, *distance, *fifo; /* By tile, for searches. */
+  int seen_stamp;
+  int dirty_low, dirty_high; /* Positions changed since the best tour. */
+  int length, best_length;
+  unsigned int random;
+  unsigned long kicks;
+} sdlman_route_worker_t;
+
+/* Tour through every pellet reachable in a world of any size, ignoring
+ * enemies. Stop 0 is where the player starts, the tour does not return. */
+typedef struct sdlman_route_s {
+  char *world;
+  int width, height;
+  int stops;
+  int *tile; /* By stop. */
+  int *stop; /* By tile, -1 if not a stop. */
+  int *candidate; /* SDLMAN_ROUTE_CANDIDATES by stop, nearest first. */
+  int *candidate_distance;
+  int *tour; /* Best found so far. */
+  int *next_distance; /* By stop, along tour. */
+  int length, initial_length; /* In steps. */
+  int workers;
+  sdlman_route_worker_t *worker[SDLMAN_PARALLEL_MAX_WORKERS];
+  Uint64 deadline;
+  unsigned long kicks;
+} sdlman_route_t;
+
+#define SDLMAN_SPRITES (1 + SDLMAN_ENEMY_COUNT) /* Player, then enemies. */
+#define SDLMAN_SPRITE_STEPS 8 /* Animation steps, the player's chomp. */
+#define SDLMAN_SPRITE_KEY 0xff00ff /* Colour around sprites, not drawn. */
+
+/* Player and enemy sheets in one surface, with the source rectangle of
+ * every sprite by sprite, boosted, direction and animation step. Enemies
+ * look the same in every direction. The black around each sprite is
+ * changed to the colour key, black inside it is kept. */
+typedef struct sdlman_atlas_s {
+  SDL_Surface *surface;
+  SDL_Rect rect[SDLMAN_SPRITES][2][5][SDLMAN_SPRITE_STEPS];
+} sdlman_atlas_t;
+
+#define SDLMAN_CAPTURE_FRAMES 8 /* Ring size, in screen copies. */
+
+/* Frames shown, copied into a ring and written out on a thread of its own.
+ * The ring is only ever read by the writer between tail and head. */
+typedef struct sdlman_capture_s {
+  FILE *fh;
+  int pipe; /* Opened with popen(). */
+  int y4m; /* Else raw RGB. */
+  int width, height, bytes_per_pixel;
+  SDL_PixelFormat format; /* Of the screen, without palette. */
+  Uint8 *frame[SDLMAN_CAPTURE_FRAMES]; /* Screen copies, rows packed. */
+  Uint32 frame_tick[SDLMAN_CAPTURE_FRAMES]; /* Loop cycle by the clock. */
+  Uint8 *rgb, *yuv; /* Last frame converted, as written. */
+  int frame_size; /* Bytes written per frame, without header. */
+  unsigned long head, tail;
+  Uint32 capture_tick, write_tick; /* Of the last frame in and out. */
+  int quit, failed;
+  SDL_mutex *lock;
+  SDL_cond *wake;
+  SDL_Thread *thread;
+  unsigned long captured, dropped, written, repeated;
+} sdlman_capture_t;
+
+#define SDLMAN_MAX_SCALE 4
+
+/* The window, and the screen surface everything is drawn into at the native
+ * size. When scaled, the screen is copied into the window with each pixel
+ * repeated. */
+typedef struct sdlman_display_s {
+  SDL_Surface *window;
+  SDL_Surface *screen; /* The window itself when not scaled. */
+  int scale;
+  sdlman_capture_t *capture; /* NULL if not recording. */
+} sdlman_display_t;
+
+/* What the renderer needs of one loop cycle, copied out by the game. */
+typedef struct sdlman_snapshot_sprite_s {
+  int x, y;
+  int direction, step; /* Index into the atlas. */
+  int visible;
+} sdlman_snapshot_sprite_t;
+
+typedef struct sdlman_snapshot_s {
+  sdlman_snapshot_sprite_t sprite[SDLMAN_SPRITES];
+  int boosted;
+  int eaten; /* Length of the eaten pellet log when taken. */
+} sdlman_snapshot_t;
+
+/* Draws the latest snapshot on a thread of its own. Snapshots go through
+ * three slots, written, ready and drawn, so the game never waits for it. */
+typedef struct sdlman_render_s {
+  sdlman_display_t *display;
+  SDL_Surface *world; /* Without pellets, for erasing them. */
+  SDL_Surface *background; /* World with the pellets left. */
+  sdlman_atlas_t *atlas;
+  sdlman_pellet_t *pellet; /* Only positions are read when drawing. */
+  int total_pellets;
+  int eaten_pellet[SDLMAN_MAX_PELLET]; /* Log in the order eaten. */
+  char logged[SDLMAN_MAX_PELLET]; /* Game side, pellets in the log. */
+  int eaten, erased; /* Log entries written, and erased from background. */
+  sdlman_snapshot_t snapshot[3];
+  int back, ready, front; /* Slots by use. */
+  int fresh, quit;
+  SDL_mutex *lock;
+  SDL_cond *wake;
+  SDL_Thread *thread; /* NULL if drawing on the game thread. */
+  SDL_Rect drawn[SDLMAN_SPRITES]; /* Sprites in the last frame. */
+  int redraw;
+  unsigned long published, frames;
+} sdlman_render_t;
+
+#define SDLMAN_RASTER_WIDTH (SDLMAN_WORLD_X_SIZE * SDLMAN_BLOCK_SIZE)
+#define SDLMAN_RASTER_HEIGHT (SDLMAN_WORLD_Y_SIZE * SDLMAN_BLOCK_SIZE)
+#define SDLMAN_RASTER_ATLAS_WIDTH (SDLMAN_CHARACTER_SIZE * 16)
+#define SDLMAN_RASTER_ATLAS_HEIGHT (SDLMAN_CHARACTER_SIZE * 4)
+#define SDLMAN_RASTER_OBS_SIZE 84 /* Observation width and height. */
+#define SDLMAN_RASTER_BOX 4 /* Box filter size, before resampling. */
+#define SDLMAN_RASTER_TAPS 3 /* Box filtered cells per observation cell. */
+
+/* Draws games into memory without SDL video, with the sprites from the
+ * atlas in colour and gray. Holds the frames observations are made from,
+ * so each thread needs its own. */
+typedef struct sdlman_raster_s {
+  SDL_Rect rect[SDLMAN_SPRITES][2][5][SDLMAN_SPRITE_STEPS];
+  Uint32 color[SDLMAN_RASTER_ATLAS_HEIGHT][SDLMAN_RASTER_ATLAS_WIDTH];
+  Uint8 gray[SDLMAN_RASTER_ATLAS_HEIGHT][SDLMAN_RASTER_ATLAS_WIDTH];
+  Uint8 mask[SDLMAN_RASTER_ATLAS_HEIGHT][SDLMAN_RASTER_ATLAS_WIDTH];
+  Uint8 frame[SDLMAN_RASTER_HEIGHT][SDLMAN_RASTER_WIDTH]; /* Gray. */
+  /* Box filtered, then resampled down, with padding given zero weight. */
+  Uint8 box[(SDLMAN_RASTER_HEIGHT / SDLMAN_RASTER_BOX) + SDLMAN_RASTER_TAPS]
+    [SDLMAN_RASTER_WIDTH / SDLMAN_RASTER_BOX];
+  Sint16 column[SDLMAN_RASTER_OBS_SIZE]
+    [(SDLMAN_RASTER_WIDTH / SDLMAN_RASTER_BOX) + SDLMAN_RASTER_TAPS + 1];
+  int first_x[SDLMAN_RASTER_OBS_SIZE], first_y[SDLMAN_RASTER_OBS_SIZE];
+  /* Weights padded with zero to four, for 64-bit loads. */
+  Sint16 weight_x[SDLMAN_RASTER_OBS_SIZE][SDLMAN_RASTER_TAPS + 1];
+  Sint16 weight_y[SDLMAN_RASTER_OBS_SIZE][SDLMAN_RASTER_TAPS + 1];
+} sdlman_raster_t;
+
+/* Hierarchical path finding over any size of world. */
+#define SDLMAN_HPA_LANDMARKS 16
+
+typedef struct sdlman_hpa_node_s {
+  int tile;
+  int cluster;
+  int region;
+} sdlman_hpa_node_t;
+
+typedef struct sdlman_hpa_edge_s {
+  int to;
+  int cost;
+} sdlman_hpa_edge_t;
+
+typedef struct sdlman_hpa_cache_s {
+  int from, to; /* Abstract nodes, from is -1 if unused. */
+  int next; /* Next node on the path, -1 at the end. */
+  int cost;
+} sdlman_hpa_cache_t;
+
+typedef struct sdlman_hpa_s {
+  char *world;
+  int width, height, cluster_size, clusters_x, clusters_y;
+  int *node_of_tile; /* -1 if tile is not an entrance. */
+  sdlman_hpa_node_t *node;
+  int nodes;
+  int *cluster_first, *cluster_node; /* Nodes grouped by cluster. */
+  int *edge_first; /* Edges grouped by node. */
+  sdlman_hpa_edge_t *edge;
+  int edges;
+  /* Second level, regions of clusters. Gates are the entrances with a
+   * transition out of their region, and come first in each region. */
+  int region_size, regions_x, regions_y;
+  int *region_first, *region_node, *slot; /* Nodes grouped by region. */
+  int *hop_first; /* Start of each region's tables, by gate then slot. */
+  unsigned short *hop, *hop_cost; /* Slot of the next node, and cost left. */
+  int gates, *gate_first, *gate, *gate_node; /* Numbered region by region. */
+  int *gate_edge_first, *gate_inner; /* Transitions before inner edges. */
+  sdlman_hpa_edge_t *gate_edge;
+  int gate_edges;
+  unsigned short *region_distance; /* By gate then region, to its nearest gate. */
+  int landmarks, *landmark_distance; /* By gate then landmark. */
+  sdlman_hpa_cache_t *cache; /* Abstract path cache, direct mapped. */
+  int cache_mask;
+  /* Query scratch, so an instance must only be used by one thread. */
+  int search, *cost, *parent, *stamp, *goal_cost, *goal_stamp;
+  int *heap_key, *heap_tie, *heap_node, heap_size;
+  int *start_node, *start_cost, *path, path_length;
+  int landmark_far[SDLMAN_HPA_LANDMARKS], landmark_near[SDLMAN_HPA_LANDMARKS];
+  int *region_bound, *estimate, *start_via, *finish_cost, *finish_via, *finish_stamp;
+  int *route, *route_cost, route_length;
+  int *local_distance, *local_queue;
+  unsigned long queries, cache_hits, searches;
+} sdlman_hpa_t;
+
+/* Bit-parallel breadth first search, one bit per tile. Rows are padded
+ * with a zero guard word on each side. */
+typedef struct sdlman_bitfill_s {
+  int width, height;
+  int words; /* 64-bit words per row, without guard words. */
+  int stride; /* Words per row, with guard words. */
+  int last_word, last_bit; /* Position of the rightmost tile. */
+  Uint64 *open, *visited, *frontier, *next;
+  int *cells, *next_cells; /* Row and word of each word with a frontier. */
+} sdlman_bitfill_t;
+
 /* Prototype for gameloop. */
-int sdlman_gameloop(SDL_Surface *screen, char *world_layout_file, 
-  char *world_graphic_file, int enemy_speed, int *score);
+int sdlman_gameloop(sdlman_display_t *display, char *world_layout_file, 
+  char *world_graphic_file, int enemy_speed, int autopilot, int *score);
+
+/* Prototypes for simulation. */
+int sdlman_game_load_world(char *filename, char *world);
+int sdlman_game_init(sdlman_game_t *g, char *world, int enemy_speed,
+  unsigned int seed);
+int sdlman_game_reset(sdlman_game_t *g, char *world, int enemy_speed,
+  unsigned int seed, sdlman_path_table_t *paths,
+  sdlman_reserve_search_t *search);
+void sdlman_game_free(sdlman_game_t *g);
+void sdlman_game_clone(sdlman_game_t *dst, sdlman_game_t *src);
+void sdlman_game_input(sdlman_game_t *g, int direction);
+int sdlman_game_step(sdlman_game_t *g);
+int sdlman_game_score(sdlman_game_t *g);
+int sdlman_game_random(sdlman_game_t *g);
+unsigned int sdlman_random(unsigned int *seed);
+
+/* Prototypes for pathing. */
+extern const int sdlman_direction_opposite[5];
+int sdlman_character_tile(sdlman_character_t *c);
+int sdlman_character_aligned(sdlman_character_t *c);
+int sdlman_wrap_neighbour(int width, int height, int tile, int direction);
+int sdlman_tile_neighbour(int tile, int direction);
+int sdlman_distance_map(char *world, int tile, int *distance, int *order);
+void sdlman_flee_field_init(sdlman_flee_field_t *f);
+void sdlman_flee_field_update(sdlman_flee_field_t *f, char *world,
+  int player_tile);
+void sdlman_flee_field_begin(sdlman_flee_field_t *f, int player_tile);
+int sdlman_flee_field_step(sdlman_flee_field_t *f, char *world, int units);
+int sdlman_flee_field_direction(sdlman_flee_field_t *f, int tile);
+sdlman_path_table_t *sdlman_path_table_create(char *world);
+int sdlman_path_table_step(sdlman_path_table_t *t, char *world, int rows);
+void sdlman_path_table_destroy(sdlman_path_table_t *t);
+int sdlman_path_distance(sdlman_path_table_t *t, int from, int to);
+int sdlman_path_direction(sdlman_path_table_t *t, int from, int to);
+
+/* Prototypes for maze generator. */
+int sdlman_maze_generate(char *world, int width, int height,
+  unsigned int seed, int loops);
+
+/* Prototypes for hierarchical path finding. */
+sdlman_hpa_t *sdlman_hpa_create(char *world, int width, int height,
+  int cluster_size);
+void sdlman_hpa_destroy(sdlman_hpa_t *h);
+int sdlman_hpa_path(sdlman_hpa_t *h, int from, int to, int *waypoint, int max);
+int sdlman_hpa_direction(sdlman_hpa_t *h, int from, int to);
+int sdlman_hpa_stress(int size);
+
+/* Prototypes for bit-parallel flood fill. */
+sdlman_bitfill_t *sdlman_bitfill_create(char *world, int width, int height);
+void sdlman_bitfill_destroy(sdlman_bitfill_t *b);
+int sdlman_bitfill_distance(sdlman_bitfill_t *b, int *tiles, int count,
+  int *distance);
+int sdlman_bitfill_bench(int size);
+
+/* Prototypes for cooperative pathing. */
+void sdlman_reserve_init(sdlman_reserve_t *r, int enemy_speed);
+void sdlman_reserve_search_init(sdlman_reserve_search_t *s);
+void sdlman_reserve_release(sdlman_reserve_t *r, int n);
+int sdlman_reserve_plan(sdlman_reserve_t *r, char *world, int n, int tile,
+  unsigned long tick, short *cost, int step_cost);
+
+/* Prototypes for autopilot. */
+int sdlman_bot_init(sdlman_bot_t *bot, char *world,
+  sdlman_path_table_t *paths);
+void sdlman_bot_free(sdlman_bot_t *bot);
+int sdlman_bot_direction(sdlman_bot_t *bot, char *world,
+  sdlman_character_t *player, sdlman_character_t *enemy,
+  sdlman_pellet_t *pellet, int total);
+
+/* Prototypes for tree search. */
+sdlman_mcts_t *sdlman_mcts_create(int workers);
+void sdlman_mcts_destroy(sdlman_mcts_t *m);
+int sdlman_mcts_direction(sdlman_mcts_t *m, sdlman_game_t *g);
+int sdlman_mcts_bench(char *world_layout_file);
+
+/* Prototypes for environment. */
+sdlman_env_t *sdlman_env_create(sdlman_env_obs_t *obs);
+void sdlman_env_destroy(sdlman_env_t *env);
+int sdlman_env_start(sdlman_env_t *env, char *world, int enemy_speed,
+  unsigned int seed, sdlman_path_table_t *paths);
+int sdlman_env_reset(sdlman_env_t *env, unsigned int seed, int world_number,
+  int enemy_speed);
+int sdlman_env_step(sdlman_env_t *env, int action);
+
+/* Prototypes for environment pool. */
+int sdlman_level_load(sdlman_level_t *level, int world_number);
+void sdlman_level_free(sdlman_level_t *level);
+sdlman_pool_t *sdlman_pool_create(int count, unsigned char *obs,
+  int world_number, int enemy_speed, int max_ticks, unsigned int seed);
+void sdlman_pool_destroy(sdlman_pool_t *pool);
+int sdlman_pool_step_all(sdlman_pool_t *pool, int *action, int *reward,
+  int *done);
+void sdlman_pool_encode(sdlman_pool_t *pool, unsigned char *out,
+  int batch_stride, int plane_stride, int row_stride);
+int sdlman_pool_bench(int count);
+
+/* Prototypes for observation encoder. */
+void sdlman_encode(sdlman_game_t *g, unsigned char *out, int plane_stride,
+  int row_stride);
+void sdlman_encode_batch(sdlman_game_t **g, int count, unsigned char *out,
+  int batch_stride, int plane_stride, int row_stride);
+int sdlman_encode_bench(char *world_layout_file);
+
+/* Prototypes for parallel jobs. */
+int sdlman_parallel_run(int workers, int jobs, sdlman_job_t job, void *data);
+
+/* Prototypes for player policies. */
+int sdlman_policy_load(sdlman_policy_t *p, char *name);
+void sdlman_policy_unload(sdlman_policy_t *p);
+sdlman_player_t *sdlman_player_create(void);
+void sdlman_player_destroy(sdlman_player_t *pl);
+int sdlman_player_play(sdlman_player_t *pl, sdlman_policy_t *p,
+  sdlman_level_t *level, int enemy_speed, unsigned int seed, int max_ticks);
+
+/* Prototypes for tournament. */
+int sdlman_tournament(int seeds, char **policy_name, int policies);
+
+/* Prototypes for difficulty estimate. */
+int sdlman_difficulty(int games, char *heatmap_prefix);
+
+/* Prototypes for pellet route. */
+sdlman_route_t *sdlman_route_create(char *world, int width, int height);
+void sdlman_route_destroy(sdlman_route_t *r);
+int sdlman_route_solve(sdlman_route_t *r, int time_us);
+int sdlman_route_write(sdlman_route_t *r, FILE *fh);
+int sdlman_route_tool(char *source, char *path_file);
+
+/* Prototypes for heatmap. */
+sdlman_heatmap_t *sdlman_heatmap_create(void);
+void sdlman_heatmap_destroy(sdlman_heatmap_t *h);
+void sdlman_heatmap_update(sdlman_heatmap_t *h, sdlman_game_t *g);
+void sdlman_heatmap_merge(sdlman_heatmap_t *dst, sdlman_heatmap_t *src);
+int sdlman_heatmap_write(sdlman_heatmap_t *h, char *filename);
+int sdlman_heatmap_write_pgm(sdlman_heatmap_t *h, char *world,
+  char *filename);
+
+/* Prototypes for sprites. */
+int sdlman_atlas_load(sdlman_atlas_t *a);
+void sdlman_atlas_free(sdlman_atlas_t *a);
+int sdlman_sprite_step(sdlman_character_t *c);
+
+/* Prototypes for renderer. */
+SDL_Surface *sdlman_render_surface(SDL_Surface *screen);
+sdlman_render_t *sdlman_render_start(sdlman_display_t *display,
+  SDL_Surface *world, sdlman_atlas_t *atlas, sdlman_game_t *g);
+void sdlman_render_publish(sdlman_render_t *r, sdlman_game_t *g);
+void sdlman_render_stop(sdlman_render_t *r);
+
+/* Prototypes for display. */
+int sdlman_display_open(sdlman_display_t *d, int scale);
+void sdlman_display_close(sdlman_display_t *d);
+void sdlman_display_update(sdlman_display_t *d, int count, SDL_Rect *rects);
+void sdlman_display_flip(sdlman_display_t *d);
+int sdlman_scale_bench(void);
+
+/* Prototypes for capture. */
+sdlman_capture_t *sdlman_capture_open(char *filename, SDL_Surface *screen);
+void sdlman_capture_frame(sdlman_capture_t *c, SDL_Surface *screen);
+void sdlman_capture_close(sdlman_capture_t *c);
+
+/* Prototypes for software renderer. */
+sdlman_raster_t *sdlman_raster_create(void);
+void sdlman_raster_destroy(sdlman_raster_t *r);
+void sdlman_raster_draw(sdlman_raster_t *r, sdlman_game_t *g, Uint32 *pixels,
+  int pitch);
+void sdlman_raster_draw_gray(sdlman_raster_t *r, sdlman_game_t *g,
+  Uint8 *pixels, int pitch);
+void sdlman_raster_observe(sdlman_raster_t *r, sdlman_game_t *g, Uint8 *obs);
+int sdlman_raster_bench(char *world_layout_file, char *image_prefix);
+
+/* Prototypes for timer. */
+Uint64 sdlman_timer_us(void);
+int sdlman_cpu_count(void);
+
+/* Prototypes for enemy AI. */
+int sdlman_ai_init(sdlman_ai_t *ai, char *world, int enemy_speed);
+void sdlman_ai_reset(sdlman_ai_t *ai, int enemy_speed);
+void sdlman_ai_free(sdlman_ai_t *ai);
+void sdlman_ai_update(sdlman_ai_t *ai, char *world,
+  sdlman_character_t *player, int boosted);
+int sdlman_ai_direction(sdlman_ai_t *ai, char *world,
+  sdlman_character_t *player, sdlman_character_t *enemy, int n, int boosted);
 
 #endif /* _SDLMAN_H */
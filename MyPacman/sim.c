@@ -0,0 +1,667 @@
+/* SDL-Man (Simulation)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <string.h> /* For memcpy(). */
+
+
+
+/* The one random generator, 15 bits out of a linear congruential seed. */
+unsigned int sdlman_random(unsigned int* seed)
+{
+	*seed = (*seed * 1103515245) + 12345;
+	return (*seed >> 16) & 0x7fff;
+}
+
+
+
+/* Game random generator, kept in the state so copies play out the same. */
+int sdlman_game_random(sdlman_game_t* g)
+{
+	return (int)sdlman_random(&g->random);
+}
+
+
+
+int sdlman_game_load_world(char* filename, char* world)
+{
+	int i, c, w, h;
+	FILE* fh;
+
+	fh = fopen(filename, "r");
+	if (fh == NULL) {
+		fprintf(stderr, "Error: Cannot open file '%s' for reading.\n", filename);
+		return -1;
+	}
+
+	for (i = 0; i < SDLMAN_WORLD_TILES; i++)
+		world[i] = SDLMAN_WORLD_AIR;
+
+	w = 0;
+	h = 0;
+	while ((c = fgetc(fh)) != EOF) {
+		if (c == '\n' || w >= SDLMAN_WORLD_X_SIZE) {
+			w = 0;
+			h++;
+			if (h >= SDLMAN_WORLD_Y_SIZE) {
+				fclose(fh);
+				return 0; /* Limit reached, bail out. */
+			}
+		}
+		else {
+			world[(h * SDLMAN_WORLD_X_SIZE) + w] = c;
+			w++;
+		}
+	}
+
+	fclose(fh);
+	return 0;
+}
+
+
+
+static int sdlman_locate_player(char* world, int* x, int* y)
+{
+	int i, j;
+	for (i = 0; i < SDLMAN_WORLD_Y_SIZE; i++) {
+		for (j = 0; j < SDLMAN_WORLD_X_SIZE; j++) {
+			if (world[(i * SDLMAN_WORLD_X_SIZE) + j] == SDLMAN_WORLD_PLAYER) {
+				*x = j * SDLMAN_BLOCK_SIZE;
+				*y = i * SDLMAN_BLOCK_SIZE;
+				return 0;
+			}
+		}
+	}
+	return -1; /* Not found. */
+}
+
+
+
+static int sdlman_locate_enemy(char* world, int* x, int* y, int n)
+{
+	int i, j, count;
+	count = 0;
+	for (i = 0; i < SDLMAN_WORLD_Y_SIZE; i++) {
+		for (j = 0; j < SDLMAN_WORLD_X_SIZE; j++) {
+			if (world[(i * SDLMAN_WORLD_X_SIZE) + j] == SDLMAN_WORLD_ENEMY) {
+				if (count == n) {
+					*x = j * SDLMAN_BLOCK_SIZE;
+					*y = i * SDLMAN_BLOCK_SIZE;
+					return 0;
+				}
+				count++;
+			}
+		}
+	}
+	return -1; /* Not found. */
+}
+
+
+
+static void sdlman_init_character(sdlman_character_t* c, int x, int y)
+{
+	/* starting X and Y co-ordinates is dependent on world data. */
+	c->x = x;
+	c->y = y;
+	c->moving_direction = c->looking_direction = SDLMAN_DIRECTION_NONE;
+	c->speed = 0;
+	c->draw_count = 0;
+	c->killed = 0;
+}
+
+
+
+static void sdlman_init_pellets(char* world, sdlman_pellet_t* p, int* total)
+{
+	int i, j, n;
+	n = 0;
+	for (i = 0; i < SDLMAN_WORLD_Y_SIZE; i++) {
+		for (j = 0; j < SDLMAN_WORLD_X_SIZE; j++) {
+			if ((world[(i * SDLMAN_WORLD_X_SIZE) + j] == SDLMAN_WORLD_PELLET) ||
+				(world[(i * SDLMAN_WORLD_X_SIZE) + j] == SDLMAN_WORLD_BOOSTER)) {
+				p[n].x = (j * SDLMAN_BLOCK_SIZE) + (SDLMAN_BLOCK_SIZE / 2);
+				p[n].y = (i * SDLMAN_BLOCK_SIZE) + (SDLMAN_BLOCK_SIZE / 2);
+				p[n].consumed = 0;
+
+				if (world[(i * SDLMAN_WORLD_X_SIZE) + j] == SDLMAN_WORLD_BOOSTER)
+					p[n].boost_effect = 1;
+				else
+					p[n].boost_effect = 0;
+
+				n++;
+				if (n >= SDLMAN_MAX_PELLET - 1)
+					break;
+			}
+		}
+	}
+	*total = n;
+}
+
+
+
+/* Everything about a level but the enemy path data. */
+static int sdlman_game_setup(sdlman_game_t* g, char* world, int enemy_speed,
+	unsigned int seed)
+{
+	int i, temp_x, temp_y;
+
+	memcpy(g->world, world, SDLMAN_WORLD_TILES);
+	g->random = seed;
+
+	if (sdlman_locate_player(g->world, &temp_x, &temp_y) != 0) {
+		fprintf(stderr, "Error: Could not locate player in world layout file.\n");
+		return -1;
+	}
+	else {
+		sdlman_init_character(&g->player, temp_x, temp_y);
+	}
+
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		if (sdlman_locate_enemy(g->world, &temp_x, &temp_y, i) == 0) {
+			sdlman_init_character(&g->enemy[i], temp_x, temp_y);
+		}
+		else {
+			sdlman_init_character(&g->enemy[i], 0, 0);
+			g->enemy[i].killed = 1; /* Not in this world. */
+		}
+		/* Start with random moving direction. */
+		g->enemy[i].moving_direction = (sdlman_game_random(g) % 4) + 1;
+	}
+
+	sdlman_init_pellets(g->world, g->pellet, &g->total_pellets);
+	g->consumed = 0;
+	g->booster_time = 0;
+	g->enemy_speed = enemy_speed;
+	g->bonus = 0;
+	g->status = SDLMAN_GAME_RUNNING;
+	g->enemy_moves = g->enemy_pushes = 0;
+	for (i = 0; i < SDLMAN_HEATMAP_CHARACTERS; i++)
+		g->heat_tile[i] = -1;
+
+	return 0;
+}
+
+
+
+/* Set up a level from a loaded world layout, with enemy path data. */
+int sdlman_game_init(sdlman_game_t* g, char* world, int enemy_speed,
+	unsigned int seed)
+{
+	g->heatmap = NULL;
+	if (sdlman_game_setup(g, world, enemy_speed, seed) != 0)
+		return -1;
+
+	/* Precompute enemy path data for this level. */
+	if (sdlman_ai_init(&g->ai, g->world, enemy_speed) != 0)
+		return -1;
+
+	return 0;
+}
+
+
+
+/* Set up a level like above, but with the complete path table of the same
+ * world and the enemy path search kept elsewhere, so nothing is allocated.
+ * Neither is freed with the game, and the heatmap is kept. */
+int sdlman_game_reset(sdlman_game_t* g, char* world, int enemy_speed,
+	unsigned int seed, sdlman_path_table_t* paths,
+	sdlman_reserve_search_t* search)
+{
+	if (sdlman_game_setup(g, world, enemy_speed, seed) != 0)
+		return -1;
+
+	g->ai.paths = paths;
+	g->ai.reserve.search = search;
+	g->ai.shared_paths = 1;
+	sdlman_ai_reset(&g->ai, enemy_speed);
+
+	return 0;
+}
+
+
+
+void sdlman_game_free(sdlman_game_t* g)
+{
+	sdlman_ai_free(&g->ai);
+}
+
+
+
+/* Copy of a game for looking ahead. The copy shares path data and the
+ * enemy path search with the original, so it must not outlive it, and is
+ * not freed. Copies played on other threads need a search of their own,
+ * see sdlman_mcts_iterate(). Enemy path work
+ * in the copy runs to completion instead of under a time budget, so a
+ * copy always plays out the same. */
+void sdlman_game_clone(sdlman_game_t* dst, sdlman_game_t* src)
+{
+	memcpy(dst, src, sizeof(sdlman_game_t));
+	dst->ai.shared_paths = 1;
+	dst->ai.budget_us = 0;
+	dst->heatmap = NULL; /* Look ahead is not play. */
+}
+
+
+
+/* Player input like the arrow keys, none is like letting go of the key. */
+void sdlman_game_input(sdlman_game_t* g, int direction)
+{
+	if (direction == SDLMAN_DIRECTION_NONE) {
+		if (g->player.moving_direction != SDLMAN_DIRECTION_NONE) {
+			g->player.looking_direction = g->player.moving_direction;
+			g->player.moving_direction = SDLMAN_DIRECTION_NONE;
+			g->player.speed = 0;
+		}
+	}
+	else {
+		g->player.moving_direction = direction;
+	}
+}
+
+
+
+static int sdlman_world_collision(sdlman_character_t* c, char* world)
+{
+	int cx1, cx2, cy1, cy2;
+
+	/* Find all world blocks that character is located in. */
+	if (c->x / SDLMAN_BLOCK_SIZE ==
+		(c->x + SDLMAN_CHARACTER_SIZE - 1) / SDLMAN_BLOCK_SIZE) {
+		/* Standing inside block in X direction. */
+		cx1 = c->x / SDLMAN_BLOCK_SIZE;
+		cx2 = -1;
+	}
+	else {
+		/* Between two blocks in X direction. */
+		cx1 = c->x / SDLMAN_BLOCK_SIZE;
+		cx2 = cx1 + 1;
+	}
+
+	if (c->y / SDLMAN_BLOCK_SIZE ==
+		(c->y + SDLMAN_CHARACTER_SIZE - 1) / SDLMAN_BLOCK_SIZE) {
+		/* Standing inside block in Y direction. */
+		cy1 = c->y / SDLMAN_BLOCK_SIZE;
+		cy2 = -1;
+	}
+	else {
+		/* Between two blocks in Y direction. */
+		cy1 = c->y / SDLMAN_BLOCK_SIZE;
+		cy2 = cy1 + 1;
+	}
+
+
+	/* Check all potential collision edges. (Unless indexes out of bounds.) */
+	if ((cy1 >= 0 && cy1 < SDLMAN_WORLD_Y_SIZE) &&
+		(cx1 >= 0 && cx1 < SDLMAN_WORLD_X_SIZE)) {
+		if (world[(cy1 * SDLMAN_WORLD_X_SIZE) + cx1] == SDLMAN_WORLD_WALL)
+			return 1;
+	}
+
+	if ((cy2 >= 0 && cy2 < SDLMAN_WORLD_Y_SIZE) &&
+		(cx1 >= 0 && cx1 < SDLMAN_WORLD_X_SIZE)) {
+		if (world[(cy2 * SDLMAN_WORLD_X_SIZE) + cx1] == SDLMAN_WORLD_WALL)
+			return 1;
+	}
+
+	if ((cy1 >= 0 && cy1 < SDLMAN_WORLD_Y_SIZE) &&
+		(cx2 >= 0 && cx2 < SDLMAN_WORLD_X_SIZE)) {
+		if (world[(cy1 * SDLMAN_WORLD_X_SIZE) + cx2] == SDLMAN_WORLD_WALL)
+			return 1;
+	}
+
+	if ((cy2 >= 0 && cy2 < SDLMAN_WORLD_Y_SIZE) &&
+		(cx2 >= 0 && cx2 < SDLMAN_WORLD_X_SIZE)) {
+		if (world[(cy2 * SDLMAN_WORLD_X_SIZE) + cx2] == SDLMAN_WORLD_WALL)
+			return 1;
+	}
+
+
+	/* Handle wrapping if character completely outside screen area. */
+	if (c->y > (SDLMAN_WORLD_Y_SIZE * SDLMAN_BLOCK_SIZE) - 1) {
+		c->y = 0 - SDLMAN_CHARACTER_SIZE + 1;
+	}
+
+	if (c->x > (SDLMAN_WORLD_X_SIZE * SDLMAN_BLOCK_SIZE) - 1) {
+		c->x = 0 - SDLMAN_CHARACTER_SIZE + 1;
+	}
+
+	if (c->y < 0 - SDLMAN_CHARACTER_SIZE + 1) {
+		c->y = (SDLMAN_WORLD_Y_SIZE * SDLMAN_BLOCK_SIZE) - 1;
+	}
+
+	if (c->x < 0 - SDLMAN_CHARACTER_SIZE + 1) {
+		c->x = (SDLMAN_WORLD_X_SIZE * SDLMAN_BLOCK_SIZE) - 1;
+	}
+
+
+	return 0; /* No collision. */
+}
+
+
+
+static int sdlman_character_collision(sdlman_character_t* c1,
+	sdlman_character_t* c2)
+{
+	if (c1->y >= c2->y - SDLMAN_CHARACTER_SIZE &&
+		c1->y <= c2->y + SDLMAN_CHARACTER_SIZE) {
+		if (c1->x >= c2->x - SDLMAN_CHARACTER_SIZE &&
+			c1->x <= c2->x + SDLMAN_CHARACTER_SIZE) {
+			return 1;
+		}
+	}
+	return 0; /* No collision. */
+}
+
+
+
+/* Whether enemy n may have run into another enemy, which takes one on the
+ * same tile or a touching one. Wrapped like sdlman_character_tile. */
+static int sdlman_enemy_crowded(sdlman_game_t* g, int n)
+{
+	int i, tile, other, dx, dy;
+
+	tile = sdlman_character_tile(&g->enemy[n]);
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		if (i == n || g->enemy[i].killed)
+			continue;
+		other = sdlman_character_tile(&g->enemy[i]);
+		dx = abs((other % SDLMAN_WORLD_X_SIZE) - (tile % SDLMAN_WORLD_X_SIZE));
+		dy = abs((other / SDLMAN_WORLD_X_SIZE) - (tile / SDLMAN_WORLD_X_SIZE));
+		if ((dx <= 1 || dx == SDLMAN_WORLD_X_SIZE - 1) &&
+			(dy <= 1 || dy == SDLMAN_WORLD_Y_SIZE - 1))
+			return 1;
+	}
+
+	return 0;
+}
+
+
+
+/* Consume pellets under the character, returns number consumed and sets
+ * boost_effect if any of them was a booster. */
+static int sdlman_pellet_collision(sdlman_character_t* c, sdlman_pellet_t* p,
+	int total, int* boost_effect)
+{
+	int i, consumed;
+
+	*boost_effect = 0;
+
+	consumed = 0;
+	for (i = 0; i < total; i++) {
+		if (p[i].consumed)
+			continue;
+
+		if (c->y >= p[i].y - SDLMAN_CHARACTER_SIZE && c->y <= p[i].y) {
+			if (c->x >= p[i].x - SDLMAN_CHARACTER_SIZE && c->x <= p[i].x) {
+				p[i].consumed = 1;
+				if (p[i].boost_effect)
+					* boost_effect = 1;
+				consumed++;
+			}
+		}
+	}
+
+	return consumed;
+}
+
+
+
+/* One loop cycle of the level, returns the events that happened. */
+int sdlman_game_step(sdlman_game_t* g)
+{
+	int i, j, collision, pushed, probe, direction, boost_effect, events;
+	sdlman_character_t* e;
+
+	if (g->status != SDLMAN_GAME_RUNNING)
+		return 0;
+	events = 0;
+
+
+	/* Move player and check for world collisions. */
+	switch (g->player.moving_direction) {
+	case SDLMAN_DIRECTION_UP:
+		g->player.speed++;
+		if (g->player.speed > SDLMAN_MAX_PLAYER_SPEED)
+			g->player.speed--;
+		g->player.y -= g->player.speed;
+		/* Keep moving back step by step, until at edge of wall. */
+		while (sdlman_world_collision(&g->player, g->world) != 0)
+			g->player.y++;
+		break;
+
+	case SDLMAN_DIRECTION_DOWN:
+		g->player.speed++;
+		if (g->player.speed > SDLMAN_MAX_PLAYER_SPEED)
+			g->player.speed--;
+		g->player.y += g->player.speed;
+		while (sdlman_world_collision(&g->player, g->world) != 0)
+			g->player.y--;
+		break;
+
+	case SDLMAN_DIRECTION_LEFT:
+		g->player.speed++;
+		if (g->player.speed > SDLMAN_MAX_PLAYER_SPEED)
+			g->player.speed--;
+		g->player.x -= g->player.speed;
+		while (sdlman_world_collision(&g->player, g->world) != 0)
+			g->player.x++;
+		break;
+
+	case SDLMAN_DIRECTION_RIGHT:
+		g->player.speed++;
+		if (g->player.speed > SDLMAN_MAX_PLAYER_SPEED)
+			g->player.speed--;
+		g->player.x += g->player.speed;
+		while (sdlman_world_collision(&g->player, g->world) != 0)
+			g->player.x--;
+		break;
+
+	default:
+		break;
+	}
+
+
+	/* Advance enemy phase timers and run budgeted path work. */
+	sdlman_ai_update(&g->ai, g->world, &g->player, g->booster_time);
+
+
+	/* Move enemies and check for their world collisions. */
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		e = &g->enemy[i];
+		if (e->killed)
+			continue;
+
+		/* Pick a new direction from the path data when inside a block. */
+		if (sdlman_character_aligned(e)) {
+			direction = sdlman_ai_direction(&g->ai, g->world, &g->player, e, i,
+				g->booster_time);
+			if (direction != SDLMAN_DIRECTION_NONE)
+				e->moving_direction = direction;
+		}
+
+		collision = pushed = 0;
+
+		switch (e->moving_direction) {
+		case SDLMAN_DIRECTION_UP:
+			e->speed++;
+			if (e->speed > g->enemy_speed)
+				e->speed--;
+			e->y -= e->speed;
+			while (sdlman_world_collision(e, g->world) != 0) {
+				e->y++;
+				collision = 1;
+			}
+			/* Move back if collide with another enemy, which reserved paths
+			 * keep rare. */
+			probe = sdlman_enemy_crowded(g, i);
+			for (j = 0; probe && j < SDLMAN_ENEMY_COUNT; j++) {
+				if (g->enemy[j].killed)
+					continue;
+				if (j != i) {
+					while (sdlman_character_collision(e, &g->enemy[j])) {
+						e->y++;
+						collision = pushed = 1;
+					}
+				}
+			}
+			break;
+
+		case SDLMAN_DIRECTION_DOWN:
+			e->speed++;
+			if (e->speed > g->enemy_speed)
+				e->speed--;
+			e->y += e->speed;
+			while (sdlman_world_collision(e, g->world) != 0) {
+				e->y--;
+				collision = 1;
+			}
+			probe = sdlman_enemy_crowded(g, i);
+			for (j = 0; probe && j < SDLMAN_ENEMY_COUNT; j++) {
+				if (g->enemy[j].killed)
+					continue;
+				if (j != i) {
+					while (sdlman_character_collision(e, &g->enemy[j])) {
+						e->y--;
+						collision = pushed = 1;
+					}
+				}
+			}
+			break;
+
+		case SDLMAN_DIRECTION_LEFT:
+			e->speed++;
+			if (e->speed > g->enemy_speed)
+				e->speed--;
+			e->x -= e->speed;
+			while (sdlman_world_collision(e, g->world) != 0) {
+				e->x++;
+				collision = 1;
+			}
+			probe = sdlman_enemy_crowded(g, i);
+			for (j = 0; probe && j < SDLMAN_ENEMY_COUNT; j++) {
+				if (g->enemy[j].killed)
+					continue;
+				if (j != i) {
+					while (sdlman_character_collision(e, &g->enemy[j])) {
+						e->x++;
+						collision = pushed = 1;
+					}
+				}
+			}
+			break;
+
+		case SDLMAN_DIRECTION_RIGHT:
+			e->speed++;
+			if (e->speed > g->enemy_speed)
+				e->speed--;
+			e->x += e->speed;
+			while (sdlman_world_collision(e, g->world) != 0) {
+				e->x--;
+				collision = 1;
+			}
+			probe = sdlman_enemy_crowded(g, i);
+			for (j = 0; probe && j < SDLMAN_ENEMY_COUNT; j++) {
+				if (g->enemy[j].killed)
+					continue;
+				if (j != i) {
+					while (sdlman_character_collision(e, &g->enemy[j])) {
+						e->x--;
+						collision = pushed = 1;
+					}
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		g->enemy_moves++;
+		if (pushed)
+			g->enemy_pushes++;
+
+		/* Change direction to target, or random if of no help. */
+		if (collision) {
+			direction = sdlman_ai_direction(&g->ai, g->world, &g->player, e, i,
+				g->booster_time);
+			if (direction != SDLMAN_DIRECTION_NONE &&
+				direction != e->moving_direction)
+				e->moving_direction = direction;
+			else
+				e->moving_direction = (sdlman_game_random(g) % 4) + 1;
+		}
+	}
+
+
+	/* Check collisions between player and enemies. */
+	for (i = 0; i < SDLMAN_ENEMY_COUNT; i++) {
+		if (g->enemy[i].killed)
+			continue;
+		if (sdlman_character_collision(&g->player, &g->enemy[i])) {
+			if (g->booster_time > 0) {
+				g->enemy[i].killed = 1;
+				g->bonus += SDLMAN_SCORE_ENEMY;
+				events |= SDLMAN_GAME_CHOMP;
+			}
+			else {
+				g->status = SDLMAN_GAME_KILLED;
+			}
+		}
+	}
+
+
+	/* Check pellet collisions, and finish if last pellet was consumed. */
+	i = sdlman_pellet_collision(&g->player, g->pellet, g->total_pellets,
+		&boost_effect);
+	if (i > 0) {
+		events |= SDLMAN_GAME_CHOMP;
+		g->consumed += i;
+		if (g->consumed == g->total_pellets) {
+			g->bonus += SDLMAN_SCORE_FINISH; /* Extra score for consuming all. */
+			if (g->status == SDLMAN_GAME_RUNNING)
+				g->status = SDLMAN_GAME_CLEARED;
+		}
+		if (boost_effect)
+			g->booster_time = SDLMAN_BOOSTER_TIME;
+	}
+	if (g->booster_time > 0)
+		g->booster_time--;
+
+	if (g->heatmap != NULL)
+		sdlman_heatmap_update(g->heatmap, g);
+
+	return events;
+}
+
+
+
+/* Score the way the level ends, pellets and bonuses times enemy speed. */
+int sdlman_game_score(sdlman_game_t* g)
+{
+	int score;
+
+	score = (g->bonus + (g->consumed * SDLMAN_SCORE_PELLET)) * g->enemy_speed;
+	if (score < 0)
+		score = 0;
+
+	return score;
+}
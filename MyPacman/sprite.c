@@ -0,0 +1,211 @@
+/* SDL-Man (Sprites)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+
+
+
+/* Frame of the sheet shown at each animation step. */
+static const int sdlman_player_frame[SDLMAN_SPRITE_STEPS] = {
+	0, 1, 2, 3, 3, 2, 1, 0,
+};
+
+static const int sdlman_enemy_frame[SDLMAN_SPRITE_STEPS] = {
+	0, 1, 2, 3, 0, 1, 2, 3,
+};
+
+
+
+static SDL_Surface* sdlman_atlas_sheet(char* filename, char* name)
+{
+	SDL_Surface* s;
+
+	s = SDL_LoadBMP(filename);
+	if (s == NULL)
+		fprintf(stderr, "Error: Unable to load %s graphics: %s\n", name,
+			SDL_GetError());
+
+	return s;
+}
+
+
+
+/* Sheets have a row of four frames per direction or enemy, unboosted above
+ * boosted. No direction looks up. */
+static void sdlman_atlas_table(sdlman_atlas_t* a)
+{
+	int sprite, boosted, direction, step, column;
+	SDL_Rect* r;
+
+	for (sprite = 0; sprite < SDLMAN_SPRITES; sprite++) {
+		for (boosted = 0; boosted < 2; boosted++) {
+			for (direction = 0; direction < 5; direction++) {
+				for (step = 0; step < SDLMAN_SPRITE_STEPS; step++) {
+					r = &a->rect[sprite][boosted][direction][step];
+					if (sprite == 0) {
+						column = (direction == SDLMAN_DIRECTION_NONE) ? 0 :
+							direction - SDLMAN_DIRECTION_UP;
+						column = (column * 4) + sdlman_player_frame[step];
+						r->y = boosted * SDLMAN_CHARACTER_SIZE;
+					}
+					else {
+						column = ((sprite - 1) * 4) + sdlman_enemy_frame[step];
+						r->y = (2 + boosted) * SDLMAN_CHARACTER_SIZE;
+					}
+					r->x = column * SDLMAN_CHARACTER_SIZE;
+					r->w = r->h = SDLMAN_CHARACTER_SIZE;
+				}
+			}
+		}
+	}
+}
+
+
+
+/* Key a sprite pixel if it is black, and remember it to look around. */
+static void sdlman_atlas_push(SDL_Surface* s, int left, int top, int n,
+	int* stack, int* count)
+{
+	Uint32* pixel;
+
+	pixel = (Uint32*)((Uint8*)s->pixels +
+		((top + (n / SDLMAN_CHARACTER_SIZE)) * s->pitch)) +
+		left + (n % SDLMAN_CHARACTER_SIZE);
+	if ((*pixel & 0xffffff) != 0)
+		return;
+	*pixel = SDLMAN_SPRITE_KEY;
+	stack[(*count)++] = n;
+}
+
+
+
+/* Change the black that can be reached from the edge of a sprite to the
+ * colour key, so enemy eyes stay black. Pixels are keyed when pushed, so
+ * each is pushed once at most. */
+static void sdlman_atlas_key(SDL_Surface* s, int left, int top)
+{
+	int i, x, y, n, count;
+	int stack[SDLMAN_CHARACTER_SIZE * SDLMAN_CHARACTER_SIZE];
+
+	count = 0;
+	for (i = 0; i < SDLMAN_CHARACTER_SIZE; i++) {
+		sdlman_atlas_push(s, left, top, i, stack, &count);
+		sdlman_atlas_push(s, left, top,
+			((SDLMAN_CHARACTER_SIZE - 1) * SDLMAN_CHARACTER_SIZE) + i,
+			stack, &count);
+		sdlman_atlas_push(s, left, top, i * SDLMAN_CHARACTER_SIZE,
+			stack, &count);
+		sdlman_atlas_push(s, left, top,
+			(i * SDLMAN_CHARACTER_SIZE) + SDLMAN_CHARACTER_SIZE - 1,
+			stack, &count);
+	}
+
+	while (count > 0) {
+		n = stack[--count];
+		x = n % SDLMAN_CHARACTER_SIZE;
+		y = n / SDLMAN_CHARACTER_SIZE;
+		if (x > 0)
+			sdlman_atlas_push(s, left, top, n - 1, stack, &count);
+		if (x < SDLMAN_CHARACTER_SIZE - 1)
+			sdlman_atlas_push(s, left, top, n + 1, stack, &count);
+		if (y > 0)
+			sdlman_atlas_push(s, left, top, n - SDLMAN_CHARACTER_SIZE,
+				stack, &count);
+		if (y < SDLMAN_CHARACTER_SIZE - 1)
+			sdlman_atlas_push(s, left, top, n + SDLMAN_CHARACTER_SIZE,
+				stack, &count);
+	}
+}
+
+
+
+/* Load the player sheet above the enemy sheet, into a 32-bit RGB surface
+ * with a colour key, that can be converted to the display format or read
+ * directly. */
+int sdlman_atlas_load(sdlman_atlas_t* a)
+{
+	int x, y;
+	SDL_Surface* player, * enemy;
+	SDL_Rect dst;
+
+	a->surface = NULL;
+	player = sdlman_atlas_sheet("player.bmp", "player");
+	if (player == NULL)
+		return -1;
+	enemy = sdlman_atlas_sheet("enemy.bmp", "enemy");
+	if (enemy == NULL) {
+		SDL_FreeSurface(player);
+		return -1;
+	}
+
+	a->surface = SDL_CreateRGBSurface(SDL_SWSURFACE,
+		SDLMAN_CHARACTER_SIZE * 16, SDLMAN_CHARACTER_SIZE * 4, 32,
+		0x00ff0000, 0x0000ff00, 0x000000ff, 0);
+	if (a->surface == NULL) {
+		fprintf(stderr, "Error: Unable to create sprite atlas: %s\n",
+			SDL_GetError());
+		SDL_FreeSurface(player);
+		SDL_FreeSurface(enemy);
+		return -1;
+	}
+
+	dst.x = dst.y = 0;
+	SDL_BlitSurface(player, NULL, a->surface, &dst);
+	dst.x = 0;
+	dst.y = SDLMAN_CHARACTER_SIZE * 2;
+	SDL_BlitSurface(enemy, NULL, a->surface, &dst);
+	SDL_FreeSurface(player);
+	SDL_FreeSurface(enemy);
+
+	if (SDL_LockSurface(a->surface) == 0) {
+		for (y = 0; y < a->surface->h; y += SDLMAN_CHARACTER_SIZE) {
+			for (x = 0; x < a->surface->w; x += SDLMAN_CHARACTER_SIZE)
+				sdlman_atlas_key(a->surface, x, y);
+		}
+		SDL_UnlockSurface(a->surface);
+	}
+	SDL_SetColorKey(a->surface, SDL_SRCCOLORKEY, SDLMAN_SPRITE_KEY);
+
+	sdlman_atlas_table(a);
+	return 0;
+}
+
+
+
+void sdlman_atlas_free(sdlman_atlas_t* a)
+{
+	if (a->surface != NULL)
+		SDL_FreeSurface(a->surface);
+	a->surface = NULL;
+}
+
+
+
+/* Animation step to draw a character at, moving it on to the next. */
+int sdlman_sprite_step(sdlman_character_t* c)
+{
+	int step;
+
+	step = c->draw_count;
+	c->draw_count = (step + 1) % SDLMAN_SPRITE_STEPS;
+	return step;
+}
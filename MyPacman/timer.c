@@ -0,0 +1,70 @@
+/* SDL-Man (Timer)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sdlman.h"
+#ifdef _WIN32
+#include <windows.h> /* For performance counter. */
+#else
+#include <time.h> /* For monotonic clock. */
+#include <unistd.h> /* For processor count. */
+#endif
+
+
+
+/* Monotonic microseconds, SDL_GetTicks() is too coarse for AI budgets. */
+Uint64 sdlman_timer_us(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return (Uint64)((counter.QuadPart / frequency.QuadPart) * 1000000 +
+		((counter.QuadPart % frequency.QuadPart) * 1000000) / frequency.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((Uint64)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+#endif
+}
+
+
+
+/* Processors available for worker threads, at least one. */
+int sdlman_cpu_count(void)
+{
+	int count;
+#ifdef _WIN32
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+	count = (int)info.dwNumberOfProcessors;
+#else
+	count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+	return (count > 0) ? count : 1;
+}
@@ -0,0 +1,241 @@
+/* SDL-Man (Tournament)
+ * Version 0.3 (23/02-08)
+ * Copyright 2008 Kjetil Erga (kobolt.anarion -AT- gmail -DOT- com)
+ *
+ *
+ * This file is part of SDL-Man.
+ *
+ * SDL-Man is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SDL-Man is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SDL-Man.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sdlman.h"
+#include <math.h> /* For sqrt(). */
+
+
+
+/* Local definitions. */
+#define SDLMAN_TOURNAMENT_MAX_POLICIES 16
+#define SDLMAN_TOURNAMENT_Z 1.96 /* For 95% confidence intervals. */
+
+
+
+/* Everything the games share, results are kept per game. */
+typedef struct sdlman_tournament_s {
+	int policies, seeds;
+	sdlman_policy_t policy[SDLMAN_TOURNAMENT_MAX_POLICIES];
+	sdlman_level_t level[SDLMAN_MAX_WORLD];
+	sdlman_player_t* player[SDLMAN_PARALLEL_MAX_WORKERS];
+	int* score; /* By policy, world, enemy speed and seed. */
+} sdlman_tournament_t;
+
+
+
+static void sdlman_tournament_game(void* data, int n, int worker)
+{
+	int seed, enemy_speed, world, policy;
+	sdlman_tournament_t* t;
+	sdlman_player_t* pl;
+
+	t = (sdlman_tournament_t*)data;
+	seed = n % t->seeds;
+	enemy_speed = (n / t->seeds) % SDLMAN_MAX_ENEMY_SPEED;
+	world = (n / (t->seeds * SDLMAN_MAX_ENEMY_SPEED)) % SDLMAN_MAX_WORLD;
+	policy = n / (t->seeds * SDLMAN_MAX_ENEMY_SPEED * SDLMAN_MAX_WORLD);
+
+	t->score[n] = -1;
+	if (t->level[world].paths == NULL)
+		return; /* World not loaded. */
+
+	/* Every policy gets the same seeds. */
+	pl = t->player[worker];
+	if (sdlman_player_play(pl, &t->policy[policy], &t->level[world],
+		enemy_speed + 1, seed + 1, SDLMAN_AUTOPILOT_TIME) >= 0)
+		t->score[n] = sdlman_game_score(&pl->env->game);
+}
+
+
+
+static void sdlman_tournament_stats(int* score, int count, double* mean,
+	double* interval)
+{
+	int i, n;
+	double sum, squares, variance;
+
+	n = 0;
+	sum = squares = 0.0;
+	for (i = 0; i < count; i++) {
+		if (score[i] < 0)
+			continue;
+		n++;
+		sum += score[i];
+		squares += (double)score[i] * score[i];
+	}
+
+	*mean = *interval = 0.0;
+	if (n == 0)
+		return;
+	*mean = sum / n;
+	if (n > 1) {
+		variance = (squares - (sum * sum / n)) / (n - 1);
+		if (variance > 0.0)
+			*interval = SDLMAN_TOURNAMENT_Z * sqrt(variance / n);
+	}
+}
+
+
+
+static void sdlman_tournament_report(sdlman_tournament_t* t, int workers,
+	Uint64 elapsed)
+{
+	int i, j, w, best, per_world, per_policy;
+	int rank[SDLMAN_TOURNAMENT_MAX_POLICIES];
+	double mean[SDLMAN_TOURNAMENT_MAX_POLICIES];
+	double interval[SDLMAN_TOURNAMENT_MAX_POLICIES];
+	double world_mean, world_interval;
+
+	per_world = SDLMAN_MAX_ENEMY_SPEED * t->seeds;
+	per_policy = SDLMAN_MAX_WORLD * per_world;
+
+	for (i = 0; i < t->policies; i++) {
+		sdlman_tournament_stats(t->score + (i * per_policy), per_policy,
+			&mean[i], &interval[i]);
+		rank[i] = i;
+	}
+
+	/* Best mean score first. */
+	for (i = 0; i < t->policies; i++) {
+		best = i;
+		for (j = i + 1; j < t->policies; j++) {
+			if (mean[rank[j]] > mean[rank[best]])
+				best = j;
+		}
+		j = rank[i];
+		rank[i] = rank[best];
+		rank[best] = j;
+	}
+
+	printf("%d worlds x %d enemy speeds x %d seeds, %d workers, %.1f s.\n",
+		SDLMAN_MAX_WORLD, SDLMAN_MAX_ENEMY_SPEED, t->seeds, workers,
+		(double)elapsed / 1000000.0);
+	printf("Rank Policy                  ");
+	for (w = 0; w < SDLMAN_MAX_WORLD; w++)
+		printf(" World %d", w + 1);
+	printf("        Score\n");
+
+	for (i = 0; i < t->policies; i++) {
+		printf("%4d %-23s ", i + 1, t->policy[rank[i]].name);
+		for (w = 0; w < SDLMAN_MAX_WORLD; w++) {
+			if (t->level[w].paths == NULL) {
+				printf("       -");
+				continue;
+			}
+			sdlman_tournament_stats(t->score + (rank[i] * per_policy) +
+				(w * per_world), per_world, &world_mean, &world_interval);
+			printf(" %7.0f", world_mean);
+		}
+		printf(" %7.0f +- %.0f\n", mean[rank[i]], interval[rank[i]]);
+	}
+}
+
+
+
+static void sdlman_tournament_free(sdlman_tournament_t* t)
+{
+	int i;
+
+	for (i = 0; i < SDLMAN_PARALLEL_MAX_WORKERS; i++)
+		sdlman_player_destroy(t->player[i]);
+	for (i = 0; i < SDLMAN_MAX_WORLD; i++)
+		sdlman_level_free(&t->level[i]);
+	for (i = 0; i < t->policies; i++)
+		sdlman_policy_unload(&t->policy[i]);
+	free(t->score);
+	free(t);
+}
+
+
+
+/* Play every policy on every world and enemy speed with seeds seeds, on
+ * all processors, and print a table ranked by mean score. */
+int sdlman_tournament(int seeds, char** policy_name, int policies)
+{
+	int i, jobs, workers, loaded;
+	Uint64 start;
+	sdlman_tournament_t* t;
+
+	if (seeds < 1 || policies < 1 ||
+		policies > SDLMAN_TOURNAMENT_MAX_POLICIES) {
+		fprintf(stderr, "Error: Need at least one seed and 1 to %d policies.\n",
+			SDLMAN_TOURNAMENT_MAX_POLICIES);
+		return -1;
+	}
+
+	t = (sdlman_tournament_t*)calloc(1, sizeof(sdlman_tournament_t));
+	if (t == NULL) {
+		fprintf(stderr, "Error: Unable to allocate tournament.\n");
+		return -1;
+	}
+	t->seeds = seeds;
+
+	jobs = policies * SDLMAN_MAX_WORLD * SDLMAN_MAX_ENEMY_SPEED * seeds;
+	t->score = (int*)malloc(sizeof(int) * jobs);
+	if (t->score == NULL) {
+		fprintf(stderr, "Error: Unable to allocate tournament results.\n");
+		sdlman_tournament_free(t);
+		return -1;
+	}
+
+	for (i = 0; i < policies; i++) {
+		if (sdlman_policy_load(&t->policy[i], policy_name[i]) != 0) {
+			sdlman_tournament_free(t);
+			return -1;
+		}
+		t->policies = i + 1;
+	}
+
+	loaded = 0;
+	for (i = 0; i < SDLMAN_MAX_WORLD; i++) {
+		if (sdlman_level_load(&t->level[i], i + 1) != 0) {
+			fprintf(stderr, "Warning: Skipping world %d.\n", i + 1);
+			continue;
+		}
+		loaded++;
+	}
+	if (loaded == 0) {
+		fprintf(stderr, "Error: No world could be loaded.\n");
+		sdlman_tournament_free(t);
+		return -1;
+	}
+
+	/* A player for each worker, games are played on all processors. */
+	workers = sdlman_cpu_count();
+	if (workers > SDLMAN_PARALLEL_MAX_WORKERS)
+		workers = SDLMAN_PARALLEL_MAX_WORKERS;
+	for (i = 0; i < workers; i++) {
+		t->player[i] = sdlman_player_create();
+		if (t->player[i] == NULL) {
+			sdlman_tournament_free(t);
+			return -1;
+		}
+	}
+
+	start = sdlman_timer_us();
+	workers = sdlman_parallel_run(workers, jobs, sdlman_tournament_game, t);
+	if (workers > 0)
+		sdlman_tournament_report(t, workers, sdlman_timer_us() - start);
+
+	sdlman_tournament_free(t);
+	return (workers > 0) ? 0 : -1;
+}